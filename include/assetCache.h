@@ -0,0 +1,146 @@
+/**
+ * @file
+ *
+ * @brief Header file for assetCache.cpp
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ASSET_CACHE_H
+#define ASSET_CACHE_H
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <SDL.h>
+#include <SDL_image.h>
+
+#include "global.h"
+#include "bitMask.h"
+#include "assetPack.h"
+
+class AssetCache
+{
+    public:
+
+        // Constructor
+        AssetCache();
+
+        // Destructor
+        ~AssetCache();
+
+        // Get sprite sheet texture, loading it on first use
+        std::shared_ptr<SDL_Texture> getTexture(const std::string& filename);
+
+        // Get decoded (color keyed) image, loading it on first use
+        std::shared_ptr<SDL_Surface> getSurface(const std::string& filename);
+
+        // Get collision mask for frames of a given size, building it on first use
+        std::shared_ptr<BitMask> getMask(const std::string& filename, int width, int height);
+
+        // Check whether image pixels are premultiplied by alpha (baked)
+        bool isPremultiplied(const std::string& filename);
+
+        // Use images and masks baked into an asset pack instead of decoding them
+        bool loadPack(const std::string& filename);
+
+        // Decode image, on any thread, the caller owns the surface
+        static SDL_Surface* decode(const std::string& filename);
+
+        // Add an image decoded elsewhere, taking ownership of the surface
+        bool add(const std::string& filename, SDL_Surface* surface);
+
+        // Check whether an image is cached
+        bool isLoaded(const std::string& filename) const;
+
+        // Check whether an image is in the asset pack
+        bool isBaked(const std::string& filename) const;
+
+        // Release assets which are no longer used by anyone
+        unsigned int purge();
+
+        // Release all assets
+        void clear();
+
+        // Get number of lookups served from the cache
+        unsigned long getHits() const;
+
+        // Get number of lookups which had to load from disk
+        unsigned long getMisses() const;
+
+        // Get number of bytes held by cached assets
+        std::size_t getBytesResident() const;
+
+    private:
+        // Everything loaded from a single image file
+        struct Asset
+        {
+            std::shared_ptr<SDL_Texture> texture;
+            std::shared_ptr<SDL_Surface> surface;
+            std::map<std::pair<int, int>, std::shared_ptr<BitMask> > masks;
+            std::size_t bytes;
+            bool premultiplied;
+        };
+
+        // Assets are keyed by filename and color key
+        typedef std::pair<std::string, Uint32> AssetKey;
+
+        //@{
+        /*
+            mAssets        - loaded assets
+            mHits          - number of lookups served from the cache
+            mMisses        - number of lookups which had to load from disk
+            mBytesResident - bytes held by cached assets
+            mPack          - baked assets, if any
+         */
+        std::map<AssetKey, Asset> mAssets;
+        unsigned long mHits, mMisses;
+        std::size_t mBytesResident;
+        std::shared_ptr<AssetPack> mPack;
+        //@}
+
+        // Find asset, loading it if needed
+        Asset* find(const std::string& filename);
+
+        // Get key of an image
+        static AssetKey getKey(const std::string& filename);
+
+        // Load asset from disk
+        bool load(const std::string& filename, Asset& asset);
+
+        // Upload decoded surface, taking ownership of it
+        bool upload(const std::string& filename, SDL_Surface* surface, Asset& asset);
+
+        // Load asset from the asset pack
+        bool loadBaked(const std::string& filename, unsigned int image, Asset& asset);
+};
+
+// Assets shared by every sprite
+extern AssetCache assetCache;
+
+// Blend textures holding premultiplied alpha
+void setPremultipliedBlendMode(SDL_Texture* texture);
+
+#endif
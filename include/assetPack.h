@@ -0,0 +1,167 @@
+/**
+ * @file
+ *
+ * @brief Header file for assetPack.cpp
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include <SDL.h>
+
+#include "global.h"
+#include "mappedFile.h"
+
+/**
+ * @brief First four bytes of an asset pack ("EZAP")
+ */
+#define PACK_MAGIC 0x50415A45
+
+/**
+ * @brief Version of the asset pack format
+ */
+#define PACK_VERSION 1
+
+/**
+ * @brief Alignment of pixel and mask data in an asset pack
+ */
+#define PACK_ALIGNMENT 16
+
+/**
+ * @brief Texture format of baked pixels, bytes R, G, B, A in memory
+ */
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+#define PACK_PIXEL_FORMAT SDL_PIXELFORMAT_RGBA8888
+#else
+#define PACK_PIXEL_FORMAT SDL_PIXELFORMAT_ABGR8888
+#endif
+
+//@{
+/*
+    Asset pack layout, every field is a little-endian 32 bit integer:
+    PackHeader, nImages PackImage, nMasks PackMask, the string table
+    (NUL-terminated strings, referred to by offset), then pixel and mask
+    data, each aligned to PACK_ALIGNMENT bytes.
+
+    Pixels are width*height*4 bytes, R, G, B, A, color key already turned
+    into transparency and color premultiplied by alpha. Masks are the
+    words of a BitMask, little-endian 64 bit integers.
+ */
+struct PackHeader
+{
+    Uint32 magic;
+    Uint32 version;
+    Uint32 nImages;
+    Uint32 nMasks;
+    Uint32 stringsOffset;
+    Uint32 stringsSize;
+};
+
+struct PackImage
+{
+    Uint32 name;
+    Sint32 width;
+    Sint32 height;
+    Uint32 pixels;
+};
+
+struct PackMask
+{
+    Uint32 name;
+    Sint32 width;
+    Sint32 height;
+    Uint32 nFrames;
+    Uint32 wordsPerRow;
+    Uint32 bits;
+};
+//@}
+
+class AssetPack
+{
+    public:
+
+        // Constructor - maps an asset pack, throws if it is not one
+        AssetPack(const std::string& filename);
+
+        // Destructor
+        ~AssetPack();
+
+        // Get index of an image by path, -1 if it was not baked
+        int findImage(const std::string& filename) const;
+
+        // Get index of the mask of an image for frames of a given size, -1 if it was not baked
+        int findMask(const std::string& filename, int width, int height) const;
+
+        // Get width of image
+        int getWidth(unsigned int i) const;
+
+        // Get height of image
+        int getHeight(unsigned int i) const;
+
+        // Get premultiplied RGBA pixels of image (PACK_PIXEL_FORMAT)
+        const void* getPixels(unsigned int i) const;
+
+        // Get number of frames of mask
+        unsigned int getNFrames(unsigned int m) const;
+
+        // Get number of 64 bit words per row of mask (including padding)
+        unsigned int getWordsPerRow(unsigned int m) const;
+
+        // Get words of mask, little-endian
+        const Uint64* getBits(unsigned int m) const;
+
+    private:
+        //@{
+        /*
+            mFile    - the asset pack, paths are relative to its directory
+            mHeader  - header, in mFile
+            mImages  - images, in mFile
+            mMasks   - masks, in mFile
+            mStrings - string table, in mFile
+         */
+        MappedFile mFile;
+        const PackHeader* mHeader;
+        const PackImage* mImages;
+        const PackMask* mMasks;
+        const char* mStrings;
+        //@}
+
+        // Check layout of the file, throws if it is broken
+        void validate();
+
+        // Get path relative to the directory of the pack
+        std::string getRelative(const std::string& filename) const;
+
+        // Get image record, throws if i is out of range
+        const PackImage& getImage(unsigned int i) const;
+
+        // Get mask record, throws if m is out of range
+        const PackMask& getMask(unsigned int m) const;
+};
+
+#endif
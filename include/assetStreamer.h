@@ -0,0 +1,151 @@
+/**
+ * @file
+ *
+ * @brief Header file for assetStreamer.cpp
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ASSET_STREAMER_H
+#define ASSET_STREAMER_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <SDL.h>
+#include <SDL_mixer.h>
+
+#include "global.h"
+#include "assetCache.h"
+
+/**
+ * @brief Default time spent uploading streamed images per frame, in ms
+ */
+#define STREAM_UPLOAD_BUDGET 2.0
+
+/**
+ * @brief Handle of a streamed asset
+ */
+typedef unsigned int StreamHandle;
+
+/**
+ * @brief Progress of a streamed asset
+ */
+enum StreamStatus
+{
+    STREAM_QUEUED,   // waiting for or being decoded
+    STREAM_DECODED,  // decoded, waiting for upload
+    STREAM_READY,    // usable
+    STREAM_FAILED    // could not be loaded
+};
+
+class AssetStreamer
+{
+    public:
+
+        // Constructor - starts nThreads loader threads (at least one)
+        AssetStreamer(unsigned int nThreads);
+
+        // Destructor - stops loader threads, dropping what was not loaded yet
+        ~AssetStreamer();
+
+        // Request image to be loaded into the asset cache in the background
+        StreamHandle requestImage(const std::string& filename);
+
+        // Request music to be loaded in the background
+        StreamHandle requestMusic(const std::string& filename);
+
+        // Get progress of a request
+        StreamStatus getStatus(StreamHandle handle) const;
+
+        // Check whether a request is done and usable
+        bool isReady(StreamHandle handle) const;
+
+        // Get texture of a ready image request, empty otherwise
+        std::shared_ptr<SDL_Texture> getTexture(StreamHandle handle) const;
+
+        // Get ready music, empty otherwise
+        std::shared_ptr<Mix_Music> getMusic(StreamHandle handle) const;
+
+        // Upload decoded images for at most budget ms (render thread only)
+        unsigned int update(double budget = STREAM_UPLOAD_BUDGET);
+
+        // Get number of requests not done yet
+        unsigned int getPending() const;
+
+    private:
+        // A requested asset
+        struct Request
+        {
+            std::string filename;
+            bool music;
+            StreamStatus status;
+            SDL_Surface* surface;
+            std::shared_ptr<SDL_Texture> texture;
+            std::shared_ptr<Mix_Music> track;
+        };
+
+        //@{
+        /*
+            mMutex    - guards everything below
+            mWake     - signalled when there is something to decode or to quit
+            mRequests - every request, the handle is the index
+            mHandles  - handle of each requested file, so requests are not repeated
+            mDecodes  - requests waiting to be decoded
+            mUploads  - requests waiting to be uploaded
+            mQuit     - loader threads should stop
+            mThreads  - loader threads
+         */
+        mutable std::mutex mMutex;
+        std::condition_variable mWake;
+        std::vector<Request> mRequests;
+        std::map<std::pair<std::string, bool>, StreamHandle> mHandles;
+        std::deque<StreamHandle> mDecodes;
+        std::deque<StreamHandle> mUploads;
+        bool mQuit;
+        std::vector<std::thread> mThreads;
+        //@}
+
+        // No copies, loader threads refer to this
+        AssetStreamer(const AssetStreamer& other);
+        AssetStreamer& operator=(const AssetStreamer& other);
+
+        // Add a request, or find the same earlier one
+        StreamHandle request(const std::string& filename, bool music);
+
+        // Get request, throws if the handle is unknown (mMutex held)
+        const Request& getRequest(StreamHandle handle) const;
+
+        // Loader thread main loop
+        void run();
+};
+
+#endif
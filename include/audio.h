@@ -0,0 +1,141 @@
+/**
+ * @file
+ *
+ * @brief Header file for audio.cpp
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include <stdio.h>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <SDL.h>
+#include <SDL_mixer.h>
+
+#include "global.h"
+
+/**
+ * @brief Default number of voices (mixer channels)
+ */
+#define AUDIO_VOICES 32
+
+/**
+ * @brief Default maximum number of voices playing the same sound
+ */
+#define AUDIO_MAX_INSTANCES 4
+
+/**
+ * @brief Id of a sound of the bank
+ */
+typedef unsigned int SoundId;
+
+class Audio
+{
+    public:
+
+        // Constructor - nVoices sounds can play at once
+        Audio(unsigned int nVoices = AUDIO_VOICES);
+
+        // Destructor - stops everything
+        ~Audio();
+
+        // Check whether there is an audio device, without one nothing plays
+        bool isOpen() const;
+
+        // Load a sound into the bank, decoding it once
+        SoundId load(const std::string& filename, int priority = 0,
+                     unsigned int maxInstances = AUDIO_MAX_INSTANCES);
+
+        // Play a sound, returns its voice or -1 if it was dropped
+        int play(SoundId sound);
+
+        // Play music, looping, in place of the current one
+        void playMusic(const std::shared_ptr<Mix_Music>& music);
+
+        // Get number of voices
+        unsigned int getNVoices() const;
+
+        // Get number of sounds started
+        unsigned long getPlayed() const;
+
+        // Get number of voices stolen from other sounds
+        unsigned long getStolen() const;
+
+        // Get number of sounds dropped
+        unsigned long getDropped() const;
+
+    private:
+        // A decoded sound
+        struct Sound
+        {
+            std::shared_ptr<Mix_Chunk> chunk;
+            int priority;
+            unsigned int maxInstances;
+            Uint64 lastStart;
+        };
+
+        // What a voice was last started with
+        struct Voice
+        {
+            SoundId sound;
+            int priority;
+            Uint64 start;
+        };
+
+        //@{
+        /*
+            mOpen       - there is an audio device
+            mBufferTime - duration of one mixer buffer in performance counter units
+            mSounds     - the bank
+            mIds        - id of each loaded file
+            mVoices     - voices, indexed by mixer channel
+            mMusic      - music playing
+            mPlayed     - sounds started
+            mStolen     - voices stolen
+            mDropped    - sounds dropped
+         */
+        bool mOpen;
+        Uint64 mBufferTime;
+        std::vector<Sound> mSounds;
+        std::map<std::string, SoundId> mIds;
+        std::vector<Voice> mVoices;
+        std::shared_ptr<Mix_Music> mMusic;
+        unsigned long mPlayed, mStolen, mDropped;
+        //@}
+
+        // No copies, the mixer channels are owned
+        Audio(const Audio& other);
+        Audio& operator=(const Audio& other);
+
+        // Pick a voice for a sound, -1 if none may be used
+        int findVoice(SoundId sound);
+};
+
+#endif
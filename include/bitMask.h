@@ -0,0 +1,92 @@
+/**
+ * @file
+ *
+ * @brief Header file for bitMask.cpp
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BIT_MASK_H
+#define BIT_MASK_H
+
+#include <stdio.h>
+#include <cstddef>
+#include <vector>
+
+#include <SDL.h>
+
+#include "global.h"
+
+class BitMask
+{
+    public:
+
+        // Constructor
+        // Builds one mask per frame of a sprite sheet, frames are laid out
+        // horizontally and are width x height pixels each
+        BitMask(SDL_Surface* surface, int width, int height);
+
+        // Constructor
+        // Copies prebuilt masks, as stored by an asset pack (little-endian words)
+        BitMask(int width, int height, unsigned int nFrames, const Uint64* bits);
+
+        // Destructor
+        ~BitMask();
+
+        // Get width of a frame
+        int getWidth() const;
+
+        // Get height of a frame
+        int getHeight() const;
+
+        // Get number of frames
+        unsigned int getNFrames() const;
+
+        // Get number of 64 bit words per row (including padding)
+        unsigned int getWordsPerRow() const;
+
+        // Get row y of a given frame
+        const Uint64* getRow(unsigned int frame, int y) const;
+
+        // Check whether pixel (x,y) of a given frame is solid
+        bool isSolid(unsigned int frame, int x, int y) const;
+
+        // Get number of bytes used by the mask
+        std::size_t getBytes() const;
+
+    private:
+        //@{
+        /*
+            mWidth        - width of a frame
+            mHeight       - height of a frame
+            mNFrames      - number of frames
+            mWordsPerRow  - 64 bit words per row, including one padding word
+            mBits         - rows of every frame, one bit per pixel
+         */
+        int mWidth, mHeight;
+        unsigned int mNFrames;
+        unsigned int mWordsPerRow;
+        std::vector<Uint64> mBits;
+        //@}
+};
+
+#endif
@@ -0,0 +1,130 @@
+/**
+ * @file
+ *
+ * @brief Header file for collisionCache.cpp
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COLLISION_CACHE_H
+#define COLLISION_CACHE_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include <SDL.h>
+
+#include "global.h"
+#include "bitMask.h"
+#include "entityStore.h"
+
+/**
+ * @brief Initial number of entries of a collision cache
+ */
+#define COLLISION_CACHE_SIZE 1024
+
+/**
+ * @brief Everything the narrow phase needs to know about one side of a pair
+ * (prevX, prevY) is the position in the previous tick, the body is swept
+ * from there to (x, y). maxSpeedX and maxSpeedY bound how far the entity
+ * can move along each axis in one tick.
+ */
+struct CollisionBody
+{
+    EntityHandle handle;
+    const BitMask* mask;
+    unsigned int frame;
+    int prevX, prevY;
+    int x, y;
+    int maxSpeedX, maxSpeedY;
+};
+
+class CollisionCache
+{
+    public:
+
+        // Constructor
+        CollisionCache();
+
+        // Destructor
+        ~CollisionCache();
+
+        // Start a new tick, entries not used in the last tick are dropped
+        void beginTick();
+
+        // Check a pair for collision, reusing earlier results when possible
+        bool test(const CollisionBody& a, const CollisionBody& b);
+
+        // Forget everything, e.g. after entities were teleported
+        void clear();
+
+        // Get number of tests answered from the cache since the last clear
+        unsigned long getReused() const;
+
+        // Get number of tests skipped since contact was impossible
+        unsigned long getSkipped() const;
+
+        // Get number of tests which ran the narrow phase
+        unsigned long getTested() const;
+
+    private:
+        // Result of an earlier test of a pair
+        struct Entry
+        {
+            EntityHandle handleA, handleB;
+            Uint32 tick;
+            Uint32 skipUntil;
+            int offsetX, offsetY;
+            int prevOffsetX, prevOffsetY;
+            unsigned int frameA, frameB;
+            bool result;
+        };
+
+        //@{
+        /*
+            mEntries     - open addressing hash table, size is a power of two
+            mTick        - current tick, entries last used before the
+                           previous tick are free
+            mTouched     - entries used in this tick
+            mTouchedPrev - entries used in the previous tick
+            mReused      - tests answered by an earlier result
+            mSkipped     - tests skipped since contact was impossible
+            mTested      - tests which ran the narrow phase
+         */
+        std::vector<Entry> mEntries;
+        Uint32 mTick;
+        unsigned int mTouched, mTouchedPrev;
+        unsigned long mReused, mSkipped, mTested;
+        //@}
+
+        // Find entry of a pair, or a free entry for it
+        Entry& find(EntityHandle a, EntityHandle b);
+
+        // Check whether an entry is in use
+        bool isUsed(const Entry& entry) const;
+};
+
+// Get ticks until two bodies could possibly touch, 0 if they overlap
+unsigned int getTimeToContact(const CollisionBody& a, const CollisionBody& b);
+
+#endif
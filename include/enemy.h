@@ -35,11 +35,23 @@ class Enemy: public Sprite
     public:
 
         // Constructor
-        Enemy(int width, int height, int nSprites, std::string filename);
+        Enemy(int width, int height, int nSprites, const std::string& filename);
+
+        // Copy constructor - copies share the loaded resources
+        Enemy(const Enemy& other);
+
+        // Move constructor
+        Enemy(Enemy&& other) noexcept;
 
         // Destructor
         ~Enemy();
 
+        // Copy assignment
+        Enemy& operator=(const Enemy& other);
+
+        // Move assignment
+        Enemy& operator=(Enemy&& other) noexcept;
+
         // Get HP
         int getHP();
 
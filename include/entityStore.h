@@ -0,0 +1,243 @@
+/**
+ * @file
+ *
+ * @brief Header file for entityStore.cpp
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ENTITY_STORE_H
+#define ENTITY_STORE_H
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <SDL.h>
+
+#include "global.h"
+#include "bitMask.h"
+#include "spriteBatch.h"
+#include "stateSnapshot.h"
+#include "spriteManifest.h"
+
+/**
+ * @brief Handle to an entity
+ * The lower 32 bits are a slot number, the upper 32 bits the generation of
+ * that slot. A slot's generation changes whenever its entity is removed,
+ * so handles to removed entities can be detected.
+ */
+typedef Uint64 EntityHandle;
+
+/**
+ * @brief Handle which never refers to an entity
+ */
+#define INVALID_ENTITY 0
+
+class EntityStore
+{
+    public:
+
+        // Constructor
+        EntityStore();
+
+        // Destructor
+        ~EntityStore();
+
+        // Register a sprite type, shared by all entities spawned with it
+        // Returns the type id
+        unsigned int addType(int width, int height, unsigned int nSprites,
+                             const std::string& filename);
+
+        // Register a sprite type with its own mask image and per frame durations (ticks)
+        unsigned int addType(int width, int height, const std::string& sheet,
+                             const std::string& mask,
+                             const std::vector<unsigned int>& durations);
+
+        // Register a sprite type from a sprite manifest
+        unsigned int addType(const SpriteManifest& manifest, unsigned int sprite);
+
+        // Create entity of a given type at a given position and speed
+        // Returns a handle to the new entity, INVALID_ENTITY if full
+        EntityHandle spawn(unsigned int type, int x, int y, int vX, int vY);
+
+        // Remove entity at a given index (the last entity takes its place)
+        void erase(unsigned int i);
+
+        // Remove entity referred to by a handle
+        void remove(EntityHandle handle);
+
+        // Mark entity at a given index for removal by compact()
+        void kill(unsigned int i);
+
+        // Remove all entities marked by kill() in one pass
+        unsigned int compact();
+
+        // Check whether a handle still refers to an entity
+        bool isAlive(EntityHandle handle) const;
+
+        // Get current index of the entity referred to by a handle
+        unsigned int getIndex(EntityHandle handle) const;
+
+        // Get handle of the entity at a given index
+        EntityHandle getHandle(unsigned int i) const;
+
+        // Remove all entities
+        void clear();
+
+        // Get number of entities
+        unsigned int size() const;
+
+        // Reserve space for a number of entities
+        void reserve(unsigned int n);
+
+        // Allocate room for n entities once and never grow beyond (0 = no limit)
+        void setCapacity(unsigned int n);
+
+        // Get maximum number of entities, 0 if unlimited
+        unsigned int getCapacity() const;
+
+        // Get most entities alive at once
+        unsigned int getHighWater() const;
+
+        // Get number of times the entity arrays grew
+        unsigned long getGrowths() const;
+
+        // Get X position of entity
+        int getPosX(unsigned int i) const;
+
+        // Get Y position of entity
+        int getPosY(unsigned int i) const;
+
+        // Get X position of entity in the previous tick
+        int getPrevPosX(unsigned int i) const;
+
+        // Get Y position of entity in the previous tick
+        int getPrevPosY(unsigned int i) const;
+
+        // Get x speed of entity
+        int getVX(unsigned int i) const;
+
+        // Get y speed of entity
+        int getVY(unsigned int i) const;
+
+        // Get animation frame of entity
+        unsigned int getFrame(unsigned int i) const;
+
+        // Get ticks left until the next animation frame of entity
+        unsigned int getFrameTicks(unsigned int i) const;
+
+        // Get sprite type of entity
+        unsigned int getType(unsigned int i) const;
+
+        // Get width of entity
+        int getWidth(unsigned int i) const;
+
+        // Get height of entity
+        int getHeight(unsigned int i) const;
+
+        // Get mask of entity
+        const BitMask* getMask(unsigned int i) const;
+
+        // Remember current positions as the previous tick's positions
+        void savePos();
+
+        // Move every entity according to its speed and advance its animation
+        void update();
+
+        // Same for entities [begin, end) only
+        void update(unsigned int begin, unsigned int end);
+
+        // Queue every entity in a batch, interpolated between previous and current position
+        void draw(SpriteBatch& batch, int layer, double alpha) const;
+
+        // Add every entity to a snapshot
+        void snapshot(StateSnapshot& snapshot, int layer) const;
+
+    private:
+        //@{
+        /*
+            Sprite types, indexed by type id
+            mTypeWidth     - width of sprite
+            mTypeHeight    - height of sprite
+            mTypeNSprites  - number of sprites in the sheet
+            mTypeSheet     - shared handle to the sprite sheet
+            mTypeMask      - shared handle to the mask
+            mTypeDurations - index of the first frame duration in mDurations
+            mDurations     - ticks every animation frame of every type is shown
+         */
+        std::vector<int> mTypeWidth, mTypeHeight;
+        std::vector<unsigned int> mTypeNSprites;
+        std::vector< std::shared_ptr<SDL_Texture> > mTypeSheet;
+        std::vector< std::shared_ptr<BitMask> > mTypeMask;
+        std::vector<unsigned int> mTypeDurations, mDurations;
+        //@}
+
+        //@{
+        /*
+            Entities, indexed by entity index
+            mPosX       - x position
+            mPosY       - y position
+            mPrevPosX   - x position in the previous tick
+            mPrevPosY   - y position in the previous tick
+            mVX         - x velocity
+            mVY         - y velocity
+            mFrame      - animation frame
+            mFrameTicks - ticks left until the next animation frame
+            mType       - sprite type id
+            mSlot       - slot of the entity's handle
+            mDead       - entity marked for removal
+         */
+        std::vector<int> mPosX, mPosY, mPrevPosX, mPrevPosY, mVX, mVY;
+        std::vector<unsigned int> mFrame, mFrameTicks, mType, mSlot;
+        std::vector<unsigned char> mDead;
+        //@}
+
+        //@{
+        /*
+            Handle slots, indexed by slot number
+            mSlotIndex      - index of the entity using the slot
+            mSlotGeneration - current generation of the slot
+            mFreeSlots      - slots not used by any entity
+         */
+        std::vector<unsigned int> mSlotIndex, mSlotGeneration, mFreeSlots;
+        //@}
+
+        //@{
+        /*
+            Pool usage
+            mCapacity  - maximum number of entities, 0 if unlimited
+            mHighWater - most entities alive at once
+            mGrowths   - number of times the entity arrays grew
+         */
+        unsigned int mCapacity;
+        unsigned int mHighWater;
+        unsigned long mGrowths;
+        //@}
+
+        // Move last entity to a given index and drop the last one
+        void swapAndPop(unsigned int i);
+};
+
+#endif
@@ -0,0 +1,98 @@
+/**
+ * @file
+ *
+ * @brief Header file for frameArena.cpp
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <stddef.h>
+#include <memory>
+#include <vector>
+
+#include "global.h"
+
+class FrameArena
+{
+    public:
+
+        // Constructor
+        // capacity is the initial size in bytes, it grows to the high
+        // water mark on reset if a frame needed more
+        FrameArena(size_t capacity);
+
+        // Destructor
+        ~FrameArena();
+
+        // Get memory for one frame, aligned to align (a power of two)
+        void* allocate(size_t bytes, size_t align);
+
+        // Get memory for n objects of a plain type for one frame
+        template<typename T>
+        T* allocate(unsigned int n)
+        {
+            return static_cast<T*>(allocate(n*sizeof(T), alignof(T)));
+        }
+
+        // Release everything allocated since the last reset
+        void reset();
+
+        // Get size of the main block in bytes
+        size_t getCapacity() const;
+
+        // Get bytes allocated this frame
+        size_t getUsed() const;
+
+        // Get most bytes ever allocated in one frame
+        size_t getHighWater() const;
+
+        // Get number of allocations this frame
+        unsigned int getAllocations() const;
+
+        // Get number of allocations this frame which did not fit the main block
+        unsigned int getOverflows() const;
+
+    private:
+        //@{
+        /*
+            mBlock       - main block
+            mCapacity    - size of the main block
+            mUsed        - bytes used in the main block
+            mOverflow    - heap blocks for allocations not fitting the main block
+            mOverflowed  - bytes in mOverflow
+            mHighWater   - most bytes allocated in one frame
+            mAllocations - allocations this frame
+         */
+        std::unique_ptr<unsigned char[]> mBlock;
+        size_t mCapacity;
+        size_t mUsed;
+        std::vector< std::unique_ptr<unsigned char[]> > mOverflow;
+        size_t mOverflowed;
+        size_t mHighWater;
+        unsigned int mAllocations;
+        //@}
+};
+
+#endif
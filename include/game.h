@@ -24,8 +24,78 @@
  * You should have received a copy of the GNU General Public License
  * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
  */
- 
- #ifndef GAME_H
- #define GAME_H
- 
- #endif
+
+#ifndef GAME_H
+#define GAME_H
+
+#include <SDL.h>
+
+/**
+ * @brief Longest frame time (in seconds) fed into the simulation
+ * If a frame takes longer than this (e.g. window dragged, debugger)
+ * the simulation slows down instead of trying to catch up forever.
+ */
+#define MAX_FRAME_TIME 0.25
+
+class Game
+{
+    public:
+
+        // Constructor
+        // tickRate is the number of simulation ticks per second
+        // and maxFps the frame rate cap (0 means uncapped)
+        Game(unsigned int tickRate, unsigned int maxFps);
+
+        // Destructor
+        ~Game();
+
+        // Start a new frame, measuring the time since the last one
+        void beginFrame();
+
+        // Consume one simulation tick, if there is one due
+        bool tick();
+
+        // End frame, waiting if needed to honour the frame rate cap
+        void endFrame();
+
+        // Get interpolation factor between previous and current tick
+        double getAlpha() const;
+
+        // Get duration of a simulation tick in seconds
+        double getDt() const;
+
+        // Get number of simulation ticks per second
+        unsigned int getTickRate() const;
+
+        // Get frame rate cap
+        unsigned int getMaxFps() const;
+
+        // Get number of simulation ticks run so far
+        unsigned long getTicks() const;
+
+        // Get performance counter time the last tick consumed is due at
+        Uint64 getTickTime() const;
+
+        // Set frame rate cap (0 means uncapped)
+        void setMaxFps(unsigned int maxFps);
+
+    private:
+        //@{
+        /*
+            mTickRate    - simulation ticks per second
+            mMaxFps      - frame rate cap (0 means uncapped)
+            mDt          - duration of a simulation tick in seconds
+            mAccumulator - time not yet consumed by the simulation
+            mFrequency   - performance counter frequency
+            mFrameStart  - performance counter at the start of the frame
+            mTicks       - number of simulation ticks run so far
+            mTickTime    - performance counter time of the last tick consumed
+         */
+        unsigned int mTickRate, mMaxFps;
+        double mDt, mAccumulator;
+        Uint64 mFrequency, mFrameStart, mTickTime;
+        unsigned long mTicks;
+        //@}
+};
+
+#endif
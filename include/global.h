@@ -43,4 +43,13 @@ extern SDL_Renderer* renderer;
 //Chroma key
 extern int COLOR_KEY[3]; 
 
+//Simulation ticks per second
+extern unsigned int TICK_RATE;
+
+//Frame rate cap (0 means uncapped)
+extern unsigned int MAX_FPS;
+
+//Audio mixer buffer size in sample frames
+extern unsigned int AUDIO_BUFFER;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,154 @@
+/**
+ * @file
+ *
+ * @brief Header file for hitchDetector.cpp
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HITCH_DETECTOR_H
+#define HITCH_DETECTOR_H
+
+#include <stdio.h>
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+#include <SDL.h>
+
+#include "global.h"
+
+/**
+ * @brief Default frame budget in ms, one refresh at 60 Hz
+ */
+#define HITCH_BUDGET (1000.0/60)
+
+/**
+ * @brief Maximum number of phases per frame
+ */
+#define HITCH_MAX_PHASES 8
+
+/**
+ * @brief Lines per hitch log before it rolls over
+ */
+#define HITCH_LOG_LINES 10000
+
+// Get number of heap allocations so far, on any thread
+unsigned long getAllocations();
+
+// Get number of bytes allocated on the heap so far, on any thread
+unsigned long getAllocatedBytes();
+
+class HitchDetector
+{
+    public:
+
+        // Constructor - frames longer than budget ms are hitches
+        HitchDetector(double budget = HITCH_BUDGET);
+
+        // Destructor - closes the log
+        ~HitchDetector();
+
+        // Log hitches to a file
+        bool open(const std::string& filename);
+
+        // Start a frame
+        void beginFrame();
+
+        // End current phase of the frame and start the next one
+        void lap(const char* phase);
+
+        // End the frame, returns whether it was a hitch
+        bool endFrame(unsigned int entities, unsigned long ticks);
+
+        // Get frame budget in ms
+        double getBudget() const;
+
+        // Set frame budget in ms
+        void setBudget(double budget);
+
+        // Get number of frames so far
+        unsigned long getFrames() const;
+
+        // Get number of hitches so far
+        unsigned long getHitches() const;
+
+        // Get longest frame so far in ms
+        double getWorst() const;
+
+    private:
+        //@{
+        /*
+            mBudget      - frame budget in ms
+            mFrequency   - performance counter frequency
+            mStart       - time the detector was created
+            mFrameStart  - time the current frame started
+            mLapStart    - time the current phase started
+            mPhases      - names of the phases of the current frame
+            mPhaseTime   - time spent in each phase of the current frame
+            mNPhases     - number of phases of the current frame
+            mAllocations - allocations at the start of the frame
+            mBytes       - bytes allocated at the start of the frame
+            mLoads       - asset cache misses at the start of the frame
+            mTicks       - simulation ticks at the end of the last frame
+            mFrames      - frames so far
+            mHitches     - hitches so far
+            mWorst       - longest frame so far in ms
+         */
+        double mBudget;
+        Uint64 mFrequency;
+        Uint64 mStart;
+        Uint64 mFrameStart, mLapStart;
+        const char* mPhases[HITCH_MAX_PHASES];
+        Uint64 mPhaseTime[HITCH_MAX_PHASES];
+        unsigned int mNPhases;
+        unsigned long mAllocations, mBytes;
+        unsigned long mLoads;
+        unsigned long mTicks;
+        unsigned long mFrames, mHitches;
+        double mWorst;
+        //@}
+
+        //@{
+        /*
+            mFilename - hitch log
+            mLog      - open hitch log, NULL if not logging
+            mLines    - lines written to the current log
+         */
+        std::string mFilename;
+        FILE* mLog;
+        unsigned int mLines;
+        //@}
+
+        // No copies, the log is owned
+        HitchDetector(const HitchDetector& other);
+        HitchDetector& operator=(const HitchDetector& other);
+
+        // Convert performance counter ticks to ms
+        double toMs(Uint64 time) const;
+
+        // Write a hitch to the log, rolling it over when full
+        void write(double frameTime, unsigned long allocations, unsigned long bytes,
+                   unsigned long loads, unsigned int entities, unsigned long ticks);
+};
+
+#endif
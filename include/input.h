@@ -0,0 +1,162 @@
+/**
+ * @file
+ *
+ * @brief Header file for input.cpp
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdio.h>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <SDL.h>
+
+#include "global.h"
+
+/**
+ * @brief Things the player can do, keys are bound to them
+ */
+enum Action
+{
+    ACTION_UP,
+    ACTION_DOWN,
+    ACTION_LEFT,
+    ACTION_RIGHT,
+    N_ACTIONS
+};
+
+/**
+ * @brief Set of actions, one bit per Action
+ */
+typedef unsigned int ActionSet;
+
+/**
+ * @brief Bit of an action in an ActionSet
+ */
+#define ACTION_BIT(action) (1u << (action))
+
+class Input
+{
+    public:
+
+        // Constructor - arrow keys bound to moving
+        Input();
+
+        // Destructor
+        ~Input();
+
+        // Bind a key to an action, in addition to the keys bound already
+        void bind(SDL_Scancode key, Action action);
+
+        // Remove every key bound to an action
+        void unbind(Action action);
+
+        // Get keys bound to an action
+        std::vector<SDL_Scancode> getKeys(Action action) const;
+
+        // Load key bindings from a text file, false if it could not be read
+        bool loadBindings(const std::string& filename);
+
+        // Queue the action of a key event, false if it is not bound (main thread)
+        bool handleEvent(const SDL_Event& event);
+
+        // Apply events up to a time, returns actions active in the tick (tick thread)
+        ActionSet update(Uint64 until);
+
+        // Get time of the oldest event applied by the last update, 0 if none
+        Uint64 getAppliedTime() const;
+
+        // Report that a frame showing input of a given time was presented
+        void presented(Uint64 inputTime);
+
+        // Print every latency measurement
+        void setLatencyMode(bool latencyMode);
+
+        // Get number of latency measurements
+        unsigned long getLatencyCount() const;
+
+        // Get average latency from event to present in ms
+        double getLatencyAverage() const;
+
+        // Get maximum latency from event to present in ms
+        double getLatencyMax() const;
+
+        // Get name of an action, as used in binding files
+        static const char* getName(Action action);
+
+    private:
+        // A key press or release, timestamped
+        struct InputEvent
+        {
+            Uint64 time;
+            Action action;
+            bool pressed;
+        };
+
+        //@{
+        /*
+            mBindings  - action of every scancode, -1 if unbound
+            mDown      - keys down per action (main thread)
+            mMutex     - guards mQueue
+            mQueue     - events not applied yet, oldest first
+            mHeld      - actions held after the last update (tick thread)
+            mApplied   - time of the oldest event of the last update (tick thread)
+            mFrequency - performance counter frequency
+         */
+        std::vector<int> mBindings;
+        unsigned int mDown[N_ACTIONS];
+        std::mutex mMutex;
+        std::deque<InputEvent> mQueue;
+        ActionSet mHeld;
+        Uint64 mApplied;
+        Uint64 mFrequency;
+        //@}
+
+        //@{
+        /*
+            Latency from event to present (render thread)
+            mLatencyMode   - print every measurement
+            mLastPresented - newest input time measured
+            mLatencyCount  - measurements
+            mLatencySum    - sum of all measurements in performance counter units
+            mLatencyMax    - largest measurement in performance counter units
+         */
+        bool mLatencyMode;
+        Uint64 mLastPresented;
+        unsigned long mLatencyCount;
+        Uint64 mLatencySum, mLatencyMax;
+        //@}
+
+        // No copies, the queue is shared with other threads
+        Input(const Input& other);
+        Input& operator=(const Input& other);
+};
+
+#endif
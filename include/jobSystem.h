@@ -0,0 +1,161 @@
+/**
+ * @file
+ *
+ * @brief Header file for jobSystem.cpp
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "global.h"
+
+/**
+ * @brief Maximum number of jobs between two calls to JobSystem::reset
+ */
+#define JOB_CAPACITY 4096
+
+/**
+ * @brief Id of a job
+ */
+typedef unsigned int JobId;
+
+/**
+ * @brief Id which never refers to a job (no dependency)
+ */
+#define NO_JOB ((JobId)-1)
+
+class JobSystem
+{
+    public:
+
+        // Constructor
+        // nThreads worker threads are started, 0 runs everything on the
+        // thread calling wait
+        JobSystem(unsigned int nThreads);
+
+        // Destructor - stops worker threads
+        ~JobSystem();
+
+        // Add a job, to be run once the jobs it depends on are done
+        JobId add(const std::function<void()>& work, JobId after = NO_JOB);
+
+        // Add a job depending on several jobs
+        JobId add(const std::function<void()>& work, const std::vector<JobId>& after);
+
+        // Run body(begin, end) over [begin, end) split into chunks of at least grain
+        // Returns a job which is done once every chunk is done
+        JobId parallelFor(unsigned int begin, unsigned int end, unsigned int grain,
+                          const std::function<void(unsigned int, unsigned int)>& body,
+                          JobId after = NO_JOB);
+
+        // Wait for a job, running other jobs meanwhile
+        void wait(JobId job);
+
+        // Forget all jobs, every job must have run
+        void reset();
+
+        // Get number of worker threads
+        unsigned int getNThreads() const;
+
+    private:
+        // A job and the jobs waiting for it
+        // Either work() or, for a chunk of a parallel for, body(first, last).
+        // closed and dependents are guarded by lock; closed is set once the
+        // job ran, done only after its dependents were released.
+        struct Job
+        {
+            std::function<void()> work;
+            std::function<void(unsigned int, unsigned int)> body;
+            unsigned int first, last;
+            std::atomic<int> waiting;
+            std::atomic<bool> done;
+            std::mutex lock;
+            bool closed;
+            std::vector<JobId> dependents;
+        };
+
+        // Jobs queued by one thread, a ring buffer of JOB_CAPACITY entries
+        // (there are never more jobs than that), so queueing never allocates
+        struct Queue
+        {
+            std::vector<JobId> jobs;
+            unsigned int first, size;
+        };
+
+        //@{
+        /*
+            mJobs     - job storage, JOB_CAPACITY entries
+            mNJobs    - number of jobs added since the last reset
+            mQueues   - one queue per thread (0 is for non-worker threads)
+            mLocks    - one lock per queue
+            mThreads  - worker threads
+            mRunning  - workers should keep running
+            mQueued   - number of queued jobs
+            mSleep    - lock for sleeping workers
+            mWake     - wakes sleeping workers
+         */
+        std::unique_ptr<Job[]> mJobs;
+        std::atomic<unsigned int> mNJobs;
+        std::vector<Queue> mQueues;
+        std::unique_ptr<std::mutex[]> mLocks;
+        std::vector<std::thread> mThreads;
+        std::atomic<bool> mRunning;
+        std::atomic<int> mQueued;
+        std::mutex mSleep;
+        std::condition_variable mWake;
+        //@}
+
+        // Create a job which still waits for its creation to finish
+        JobId create();
+
+        // Make a job wait for another one
+        void depend(JobId job, JobId after);
+
+        // A dependency of a job is done, queue it if it was the last one
+        void release(JobId job);
+
+        // Put a job in the queue of the calling thread
+        void enqueue(JobId job);
+
+        // Take a job from the own queue or steal one, NO_JOB if there is none
+        JobId dequeue();
+
+        // Run a job and release its dependents
+        void run(JobId job);
+
+        // Worker thread main loop
+        void work(unsigned int index);
+};
+
+#endif
@@ -0,0 +1,78 @@
+/**
+ * @file
+ *
+ * @brief Header file for mappedFile.cpp
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include <SDL.h>
+
+class MappedFile
+{
+    public:
+
+        // Constructor - maps a file read only, throws if it can not be read
+        MappedFile(const std::string& filename);
+
+        // Destructor
+        ~MappedFile();
+
+        // Get contents of the file
+        const unsigned char* getData() const;
+
+        // Get size of the file
+        std::size_t getSize() const;
+
+        // Check whether the file is memory mapped or was read
+        bool isMapped() const;
+
+        // Get directory of the file
+        std::string getDirectory() const;
+
+    private:
+        //@{
+        /*
+            mData      - the whole file, mapped or read
+            mSize      - size of the file
+            mMapped    - whether mData is a memory mapping
+            mDirectory - directory of the file
+         */
+        const unsigned char* mData;
+        std::size_t mSize;
+        bool mMapped;
+        std::string mDirectory;
+        //@}
+
+        // No copies, the mapping is owned
+        MappedFile(const MappedFile& other);
+        MappedFile& operator=(const MappedFile& other);
+};
+
+#endif
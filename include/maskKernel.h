@@ -0,0 +1,67 @@
+/**
+ * @file
+ *
+ * @brief Header file for maskKernel.cpp
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASK_KERNEL_H
+#define MASK_KERNEL_H
+
+#include <string>
+
+#include <SDL.h>
+
+#include "global.h"
+
+/**
+ * @brief Rows of a bit mask covering an overlap rectangle
+ * first points at the word holding the first overlapping pixel of the
+ * first overlapping row, shift is the bit of that pixel in the word and
+ * stride the number of words from one row to the next.
+ */
+struct MaskRows
+{
+    const Uint64* first;
+    unsigned int stride;
+    int shift;
+};
+
+/**
+ * @brief Narrow phase kernel
+ * Checks nRows rows of nChunks 64 pixel chunks for a pixel solid in both
+ * masks. Only the bits in tailMask of the last chunk are considered.
+ */
+typedef bool (*MaskKernel)(const MaskRows& a, const MaskRows& b,
+                           int nRows, int nChunks, Uint64 tailMask);
+
+// Get kernel in use (the fastest one the CPU supports unless changed)
+MaskKernel getMaskKernel();
+
+// Get name of the kernel in use
+const char* getMaskKernelName();
+
+// Use a given kernel ("scalar", "sse2" or "avx2"), false if not supported
+bool selectMaskKernel(const std::string& name);
+
+#endif
@@ -0,0 +1,124 @@
+/**
+ * @file
+ *
+ * @brief Header file for pipeline.cpp
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <SDL.h>
+
+#include "global.h"
+#include "game.h"
+#include "input.h"
+#include "replay.h"
+#include "simulation.h"
+#include "stateSnapshot.h"
+
+class Pipeline
+{
+    public:
+
+        // Constructor
+        // The simulation must not be touched by anyone else while running,
+        // nor the input updated
+        Pipeline(Simulation& simulation, Input& input, unsigned int tickRate);
+
+        // Destructor - stops the simulation thread
+        ~Pipeline();
+
+        // Start simulation thread
+        void start();
+
+        // Stop simulation thread and wait for it
+        void stop();
+
+        // Record ticks, replay them or log their hashes, NULL for none
+        // Only while stopped.
+        void setReplay(Replay* replay);
+
+        // Stop ticking after a number of ticks, 0 for no limit
+        // Only while stopped.
+        void setMaxTicks(unsigned long ticks);
+
+        // Get latest complete snapshot (render thread only)
+        const StateSnapshot& acquire();
+
+        // Get interpolation factor for drawing a snapshot now
+        double getAlpha(const StateSnapshot& snapshot) const;
+
+        // Get number of simulation ticks run so far
+        unsigned long getTicks() const;
+
+        // Get number of collisions since the last call
+        unsigned int takeCollisions();
+
+    private:
+        //@{
+        /*
+            mSimulation - the simulation, owned by the thread while running
+            mInput      - input, updated by the thread every tick
+            mReplay     - recording or replay, may be NULL
+            mTickDt     - duration of a tick in performance counter units
+            mThread     - simulation thread
+            mRunning    - simulation thread should keep running
+            mTicks      - ticks run so far
+            mMaxTicks   - ticks after which the thread stops, 0 for no limit
+            mCollisions - collisions not taken yet
+         */
+        Simulation& mSimulation;
+        Input& mInput;
+        Replay* mReplay;
+        Uint64 mTickDt;
+        std::thread mThread;
+        std::atomic<bool> mRunning;
+        std::atomic<unsigned long> mTicks;
+        unsigned long mMaxTicks;
+        std::atomic<unsigned int> mCollisions;
+        //@}
+
+        //@{
+        /*
+            Triple buffer
+            mBuffers - the snapshots
+            mBack    - buffer being written (simulation thread only)
+            mFront   - buffer being drawn (render thread only)
+            mMiddle  - last published buffer, plus FRESH bit if not yet acquired
+         */
+        StateSnapshot mBuffers[3];
+        unsigned int mBack, mFront;
+        std::atomic<unsigned int> mMiddle;
+        //@}
+
+        // Simulation thread main loop
+        void run();
+};
+
+#endif
@@ -0,0 +1,229 @@
+/**
+ * @file
+ *
+ * @brief Header file for profiler.cpp
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdio.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <SDL.h>
+
+#include "global.h"
+
+/**
+ * @brief Number of frames kept by the profiler
+ */
+#define PROFILER_FRAMES 256
+
+/**
+ * @brief Maximum number of zones
+ */
+#define PROFILER_MAX_ZONES 32
+
+/**
+ * @brief Maximum number of threads recording zones
+ */
+#define PROFILER_MAX_TRACKS 16
+
+/**
+ * @brief Zones a thread can record between two frames
+ */
+#define PROFILER_TRACK_EVENTS 4096
+
+class Profiler
+{
+    public:
+
+        // Constructor
+        Profiler();
+
+        // Destructor
+        ~Profiler();
+
+        // Get id of a zone, registering it on first use (any thread)
+        unsigned int getZone(const char* name);
+
+        // Enter a zone, returns the start time
+        Uint64 begin();
+
+        // Leave a zone entered at a given start time
+        void end(unsigned int zone, Uint64 start);
+
+        // Name the calling thread's track in traces
+        void setThreadName(const char* name);
+
+        // Finish current frame and start a new one, collecting the zones
+        // of every thread (always called from the same thread)
+        void endFrame();
+
+        // Get number of registered zones
+        unsigned int getNZones() const;
+
+        // Get name of a zone
+        const std::string& getName(unsigned int zone) const;
+
+        // Get average time per frame (in ms) spent in a zone
+        double getAverage(unsigned int zone) const;
+
+        // Get percentile (0 - 100) of time per frame (in ms) spent in a zone
+        double getPercentile(unsigned int zone, double percentile) const;
+
+        // Write per frame, per zone times (ms) as CSV
+        bool writeCsv(const std::string& filename) const;
+
+        // Write every recorded zone in Chrome's trace event format
+        bool writeTrace(const std::string& filename) const;
+
+        // Draw per zone times on screen
+        void drawOverlay() const;
+
+        // Toggle overlay
+        void toggleOverlay();
+
+        // Check whether the overlay is shown
+        bool getOverlay() const;
+
+    private:
+        // A zone entered and left during a frame
+        struct Event
+        {
+            unsigned int zone;
+            unsigned int track;
+            unsigned int depth;
+            Uint64 start;
+            Uint64 end;
+        };
+
+        // Zones recorded by one thread, a ring of PROFILER_TRACK_EVENTS
+        // entries written by that thread and emptied by endFrame
+        struct Track
+        {
+            std::string name;
+            std::vector<Event> events;
+            std::atomic<unsigned long> written, read;
+            unsigned int id;
+            unsigned int depth;
+        };
+
+        //@{
+        /*
+            mNames     - zone names, indexed by zone id, never reallocated
+            mNZones    - number of zone names, published after each is added
+            mTracks    - one track per thread recording zones, never
+                         reallocated
+            mNTracks   - number of tracks, published after each is added
+            mLock      - serializes registration of zones and tracks, and
+                         guards the track names
+            mTime      - time per zone of the last frames, PROFILER_MAX_ZONES
+                         entries per frame, summed over all threads
+            mEvents    - zones entered and left in the last frames
+            mFrame     - number of the current frame
+            mFrequency - performance counter frequency
+            mOverlay   - overlay shown
+            mOwner     - thread which created the profiler (track "main")
+         */
+        std::vector<std::string> mNames;
+        std::atomic<unsigned int> mNZones;
+        std::vector< std::unique_ptr<Track> > mTracks;
+        std::atomic<unsigned int> mNTracks;
+        mutable std::mutex mLock;
+        std::vector<Uint64> mTime;
+        std::vector< std::vector<Event> > mEvents;
+        unsigned long mFrame;
+        Uint64 mFrequency;
+        bool mOverlay;
+        std::thread::id mOwner;
+        //@}
+
+        // Get track of the calling thread, NULL if there are too many
+        Track* getTrack();
+
+        // Get number of completed frames kept
+        unsigned int getNFrames() const;
+
+        // Get ring buffer slot of the n-th oldest completed frame
+        unsigned int getSlot(unsigned int n) const;
+
+        // Draw text with the built-in font
+        void drawText(int x, int y, int scale, const std::string& text) const;
+};
+
+// The profiler used by PROFILE_ZONE and PROFILE_FRAME
+extern Profiler profiler;
+
+/**
+ * @brief Times the enclosing scope as a profiler zone
+ */
+class ProfileScope
+{
+    public:
+
+        // Constructor - enters zone
+        ProfileScope(unsigned int zone);
+
+        // Destructor - leaves zone
+        ~ProfileScope();
+
+    private:
+        //@{
+        /*
+            mZone  - zone id
+            mStart - time the zone was entered
+         */
+        unsigned int mZone;
+        Uint64 mStart;
+        //@}
+};
+
+/**
+ * @brief Profiling macros
+ * PROFILE_ZONE(name) times the rest of the enclosing scope, PROFILE_FRAME()
+ * marks the end of a frame and PROFILE_THREAD(name) names the calling
+ * thread in traces. All compile to nothing unless ENABLE_PROFILER is
+ * defined (configure --enable-profiler).
+ */
+#ifdef ENABLE_PROFILER
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) \
+    static unsigned int PROFILE_CONCAT(profileZone_, __LINE__) = profiler.getZone(name); \
+    ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(PROFILE_CONCAT(profileZone_, __LINE__))
+#define PROFILE_FRAME() profiler.endFrame()
+#define PROFILE_THREAD(name) profiler.setThreadName(name)
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_FRAME()
+#define PROFILE_THREAD(name)
+#endif
+
+#endif
@@ -0,0 +1,54 @@
+/**
+ * @file
+ *
+ * @brief Header file for recordWriter.cpp
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RECORD_WRITER_H
+#define RECORD_WRITER_H
+
+#include <stdio.h>
+#include <map>
+#include <string>
+
+#include <SDL.h>
+
+/**
+ * @brief String table being built, equal strings are stored once
+ * Used by the offline tools for the string tables of sprite manifests and
+ * asset packs.
+ */
+struct StringTable
+{
+    std::string data;
+    std::map<std::string, Uint32> offsets;
+
+    // Add a string, get its offset in data
+    Uint32 add(const std::string& s);
+};
+
+// Write 32 bit integers little-endian, false on error
+bool writeWords(FILE* file, const Uint32* words, std::size_t n);
+
+#endif
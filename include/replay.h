@@ -0,0 +1,175 @@
+/**
+ * @file
+ *
+ * @brief Header file for replay.cpp
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <SDL.h>
+
+#include "global.h"
+#include "input.h"
+#include "mappedFile.h"
+
+/**
+ * @brief First four bytes of a recording ("EZRP")
+ */
+#define REPLAY_MAGIC 0x50525A45
+
+/**
+ * @brief Version of the recording format
+ */
+#define REPLAY_VERSION 1
+
+/**
+ * @brief Ticks between state hashes stored in a recording
+ */
+#define REPLAY_HASH_INTERVAL 60
+
+//@{
+/*
+    Recording layout, every field is a little-endian integer: ReplayHeader,
+    nRuns ReplayRun (the actions of every tick, run-length encoded), then
+    nHashes 64 bit state hashes, one after every hashInterval ticks.
+ */
+struct ReplayHeader
+{
+    Uint32 magic;
+    Uint32 version;
+    Uint32 seed;
+    Uint32 nTicks;
+    Uint32 nRuns;
+    Uint32 nHashes;
+    Uint32 hashInterval;
+};
+
+struct ReplayRun
+{
+    Uint32 actions;
+    Uint32 ticks;
+};
+//@}
+
+class Replay
+{
+    public:
+
+        // Constructor - neither recording nor replaying
+        Replay();
+
+        // Destructor - saves the recording, if any
+        ~Replay();
+
+        // Start recording a run with a given seed
+        void record(const std::string& filename, unsigned int seed);
+
+        // Load a recording to replay, throws if it is not one
+        void load(const std::string& filename);
+
+        // Write the state hash after every tick to a text file
+        bool openHashLog(const std::string& filename);
+
+        // Check whether recording
+        bool isRecording() const;
+
+        // Check whether replaying
+        bool isReplaying() const;
+
+        // Check whether there is anything to do per tick
+        bool isActive() const;
+
+        // Check whether every recorded tick was replayed
+        bool isDone() const;
+
+        // Get actions of the next tick: live ones, recorded if replaying
+        ActionSet input(ActionSet actions);
+
+        // Pass the state hash after the tick
+        void check(Uint64 hash);
+
+        // Write the recording, false if it could not be written
+        bool save();
+
+        // Get seed of the run
+        unsigned int getSeed() const;
+
+        // Get number of ticks run so far
+        unsigned long getTick() const;
+
+        // Get number of ticks recorded
+        unsigned long getNTicks() const;
+
+        // Get number of hashes differing from the recording
+        unsigned long getMismatches() const;
+
+        // Get first tick whose hash differed from the recording, 0 if none
+        unsigned long getFirstMismatch() const;
+
+        // Get last state hash passed
+        Uint64 getHash() const;
+
+    private:
+        //@{
+        /*
+            mFilename      - recording being written
+            mRecording     - recording
+            mReplaying     - replaying
+            mSeed          - seed of the run
+            mRuns          - actions of every tick, run-length encoded
+            mHashes        - state hash after every REPLAY_HASH_INTERVAL ticks
+            mRun           - run of the next tick (replaying)
+            mRunTick       - ticks of mRun used so far (replaying)
+            mTick          - ticks run
+            mNTicks        - ticks recorded
+            mHash          - last state hash
+            mMismatches    - hashes differing from the recording
+            mFirstMismatch - tick of the first mismatch
+            mHashLog       - per tick hash log, may be NULL
+         */
+        std::string mFilename;
+        bool mRecording, mReplaying;
+        unsigned int mSeed;
+        std::vector<ReplayRun> mRuns;
+        std::vector<Uint64> mHashes;
+        unsigned int mRun, mRunTick;
+        unsigned long mTick, mNTicks;
+        Uint64 mHash;
+        unsigned long mMismatches, mFirstMismatch;
+        FILE* mHashLog;
+        //@}
+
+        // No copies, the hash log is owned
+        Replay(const Replay& other);
+        Replay& operator=(const Replay& other);
+};
+
+#endif
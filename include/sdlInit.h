@@ -38,4 +38,8 @@
 
 bool sdlInit();
 
+bool sdlInitHeadless();
+
+void sdlClose();
+
 #endif
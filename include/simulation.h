@@ -0,0 +1,166 @@
+/**
+ * @file
+ *
+ * @brief Header file for simulation.cpp
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <atomic>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <SDL.h>
+
+#include "global.h"
+#include "user.h"
+#include "entityStore.h"
+#include "spatialGrid.h"
+#include "spriteBatch.h"
+#include "textureAtlas.h"
+#include "stateSnapshot.h"
+#include "jobSystem.h"
+#include "frameArena.h"
+#include "collisionCache.h"
+#include "spriteManifest.h"
+#include "input.h"
+
+class Simulation
+{
+    public:
+
+        // Constructor
+        // seed is used for everything random, so that runs can be repeated
+        Simulation(unsigned int seed);
+
+        // Destructor
+        ~Simulation();
+
+        // Run one simulation tick (all phases below, in order)
+        // actions are those active in the tick. Returns number of collisions.
+        unsigned int tick(ActionSet actions);
+
+        // Remember positions of the previous tick, for interpolation
+        void savePos();
+
+        // Move player according to the actions active
+        void input(ActionSet actions);
+
+        // Randomly create enemies
+        void spawn();
+
+        // Create a given number of enemies anywhere on screen
+        void spawn(unsigned int n);
+
+        // Remove enemies which left the screen
+        void cull();
+
+        // Move and animate everything
+        void animate();
+
+        // Check player against enemies, returns number of collisions
+        unsigned int collide();
+
+        // animate followed by collide, as jobs if a job system is set
+        unsigned int animateAndCollide();
+
+        // Run animate and collide as jobs, NULL runs them serially
+        void setJobSystem(JobSystem* jobs);
+
+        // Queue everything for drawing
+        void draw(SpriteBatch& batch, double alpha);
+
+        // Copy everything needed for drawing into a snapshot
+        void snapshot(StateSnapshot& snapshot) const;
+
+        // Add every sprite sheet in use to an atlas
+        void addSheets(TextureAtlas& atlas) const;
+
+        // Get per-tick scratch memory
+        const FrameArena& getArena() const;
+
+        // Turn reuse of narrow phase results on or off
+        void setCollisionCache(bool enabled);
+
+        // Get collision cache
+        const CollisionCache& getCollisionCache() const;
+
+        // Get player
+        const User& getPlayer() const;
+
+        // Get enemies
+        const EntityStore& getEnemies() const;
+
+        // Get hash of the state, equal in runs which are in the same state
+        Uint64 hash() const;
+
+    private:
+        //@{
+        /*
+            mManifest     - sprite definitions
+            mPlayer       - the player
+            mEnemies      - all enemies
+            mEnemyType    - sprite type of the enemies
+            mEnemyLayer   - layer enemies are drawn on
+            mPlayerLayer  - layer the player is drawn on
+            mGrid         - broad phase for collisions
+            mCandidates   - enemies which may collide with the player (in
+                            mArena)
+            mNCandidates  - number of candidates
+            mGenerator    - random number generator
+            mDistribution - distribution for spawn chance and positions
+            mJobs         - job system for the parallel phases, may be NULL
+            mArena        - scratch memory released at the start of every tick
+            mNHits        - number of enemies hit this tick
+            mCache        - narrow phase results of earlier ticks
+            mCacheEnabled - whether mCache is used
+         */
+        SpriteManifest mManifest;
+        User mPlayer;
+        EntityStore mEnemies;
+        unsigned int mEnemyType;
+        int mEnemyLayer, mPlayerLayer;
+        SpatialGrid mGrid;
+        unsigned int* mCandidates;
+        unsigned int mNCandidates;
+        std::default_random_engine mGenerator;
+        std::uniform_int_distribution<unsigned> mDistribution;
+        JobSystem* mJobs;
+        FrameArena mArena;
+        unsigned int mNHits;
+        CollisionCache mCache;
+        bool mCacheEnabled;
+        //@}
+
+        // Fill mCandidates with enemies near the player
+        void broadPhase();
+
+        // Check player against enemy i, exact per pixel
+        bool narrowTest(unsigned int i);
+};
+
+#endif
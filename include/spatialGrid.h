@@ -0,0 +1,113 @@
+/**
+ * @file
+ *
+ * @brief Header file for spatialGrid.cpp
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "global.h"
+
+class SpatialGrid
+{
+    public:
+
+        // Constructor
+        // The grid covers a width x height area (usually the window) with
+        // square cells, anything outside goes into the border cells
+        SpatialGrid(int width, int height, int cellSize);
+
+        // Destructor
+        ~SpatialGrid();
+
+        // Remove all entries
+        void clear();
+
+        // Add an axis aligned box with a given id
+        void insert(unsigned int id, int x, int y, int w, int h);
+
+        // Sort entries into cells, must be called after inserting
+        void build();
+
+        // Get ids of boxes which may overlap a given box, returns their number
+        // candidates must have room for size() ids
+        unsigned int query(int x, int y, int w, int h, unsigned int* candidates);
+
+        // Get pairs of ids whose boxes overlap
+        void getPairs(std::vector< std::pair<unsigned int, unsigned int> >& pairs) const;
+
+        // Get number of entries
+        unsigned int size() const;
+
+        // Get cell size
+        int getCellSize() const;
+
+    private:
+        //@{
+        /*
+            mCellSize   - size of the (square) cells in pixels
+            mCols       - number of cells in x
+            mRows       - number of cells in y
+         */
+        int mCellSize, mCols, mRows;
+        //@}
+
+        //@{
+        /*
+            Entries, in insertion order
+            mId         - id of entry
+            mX, mY      - top left corner of box
+            mW, mH      - size of box
+         */
+        std::vector<unsigned int> mId;
+        std::vector<int> mX, mY, mW, mH;
+        //@}
+
+        //@{
+        /*
+            Cells, stored compactly: the entries of cell c are
+            mCellEntries[mCellStart[c]] ... mCellEntries[mCellStart[c+1] - 1]
+            mCellStart   - first entry of every cell (one extra at the end)
+            mCellEntries - entry numbers sorted by cell
+            mStamp       - last query which visited an entry
+            mQuery       - number of the current query
+         */
+        std::vector<unsigned int> mCellStart, mCellEntries;
+        std::vector<unsigned int> mStamp;
+        unsigned int mQuery;
+        //@}
+
+        // Get cell column of x coordinate
+        int getCol(int x) const;
+
+        // Get cell row of y coordinate
+        int getRow(int y) const;
+};
+
+#endif
@@ -28,13 +28,20 @@
 #ifndef SPRITE_H
 #define SPRITE_H
 
+#include <algorithm>
+#include <memory>
 #include <stdexcept>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include <SDL.h>
 #include <SDL_image.h>
 
 #include "global.h"
+#include "bitMask.h"
+#include "spriteBatch.h"
+#include "stateSnapshot.h"
 
 class Sprite
 {
@@ -45,11 +52,23 @@ class Sprite
         // to know the height and width of every sprite,
         // the number of sprites in the sheet and the filename
         // of the sheet
-        Sprite(int width, int height, int nSprites, std::string filename);
+        Sprite(int width, int height, int nSprites, const std::string& filename);
+
+        // Copy constructor - copies share the loaded resources
+        Sprite(const Sprite& other);
+
+        // Move constructor
+        Sprite(Sprite&& other) noexcept;
 
         // Destructor
         ~Sprite();
 
+        // Copy assignment
+        Sprite& operator=(const Sprite& other);
+
+        // Move assignment
+        Sprite& operator=(Sprite&& other) noexcept;
+
         // Get position (x,y)
         std::pair<int, int> getPos() const;
 
@@ -59,6 +78,12 @@ class Sprite
         // Get Y position
         int getPosY() const;
 
+        // Get X position in the previous tick
+        int getPrevPosX() const;
+
+        // Get Y position in the previous tick
+        int getPrevPosY() const;
+
         // Get speed (vx, vy)
         std::pair<int, int> getV() const;
 
@@ -68,8 +93,20 @@ class Sprite
         // Get y speed
         int getVY() const;
 
+        // Get sprite width
+        int getWidth() const;
+
+        // Get sprite height
+        int getHeight() const;
+
         // Get mask
-        SDL_Surface* getMask() const;
+        const BitMask* getMask() const;
+
+        // Get current animation frame
+        unsigned int getFrame() const;
+
+        // Get ticks left until the next animation frame
+        unsigned int getFrameTicks() const;
 
         // Set sprite position
         void setPos(int x, int y);
@@ -103,15 +140,28 @@ class Sprite
         // Set speed
         void setSpeed(int vx, int vy);
 
-        // Draw current sprite to screen
-        void draw( );
+        // Remember current position as the previous tick's position
+        void savePos();
+
+        // Queue sprite in a batch, interpolated between previous and current position
+        void draw(SpriteBatch& batch, int layer, double alpha);
+
+        // Add sprite to a snapshot
+        void snapshot(StateSnapshot& snapshot, int layer) const;
 
         // Update sprite animation by a certain number of frames
         void updateFrame(unsigned int frame);
 
         // Update sprite animation exactly one frame
+        // (one tick instead if frame durations are set)
         void updateFrame();
 
+        // Use a different image for the collision mask
+        void setMask(const std::string& filename);
+
+        // Set number of ticks each animation frame is shown
+        void setFrameDurations(const std::vector<unsigned int>& durations);
+
         // Puts sprite back into the screen if it left it
         void enforceBoundary();
 
@@ -123,26 +173,33 @@ class Sprite
             mWidth     - width of sprite sprite
             mPosX      - x position of sprite
             mPosY      - y position of sprite
+            mPrevPosX  - x position of sprite in the previous tick
+            mPrevPosY  - y position of sprite in the previous tick
             mVX        - x velocity of sprite
             mVY        - y velocity of sprite
             mFrame     - frame number (Note: first frame is = 0. The last one is = nSprites - 1)
             mNSprites  - number of sprites of the sprite
-            mSprtSheet - a pointer to the loaded sprite sheet (SDL_Texture)
-            mMask      - a pointer to the loaded mask (SDL_Surface)
+            mSprtSheet - shared handle to the sprite sheet (SDL_Texture)
+            mMask      - shared handle to the collision mask (BitMask)
+            mDurations - ticks each frame is shown, empty for one tick each
+            mFrameTicks - ticks left until the next frame
          */
         int mHeight, mWidth;
         int mPosX, mPosY, mVX, mVY;
+        int mPrevPosX, mPrevPosY;
         unsigned int mFrame, mLife;
         unsigned int mNSprites;
-        SDL_Texture* mSprtSheet;
-        SDL_Surface* mMask;
+        std::shared_ptr<SDL_Texture> mSprtSheet;
+        std::shared_ptr<BitMask> mMask;
+        std::vector<unsigned int> mDurations;
+        unsigned int mFrameTicks;
         //@}
 
         // Loads sprite sheet
-        SDL_Texture* loadSpriteSheet(std::string filename);
+        std::shared_ptr<SDL_Texture> loadSpriteSheet(const std::string& filename);
 
         // Loads mask 
-        SDL_Surface* loadMask(std::string filename);
+        std::shared_ptr<BitMask> loadMask(const std::string& filename);
 
 };
 #endif
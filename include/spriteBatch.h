@@ -0,0 +1,159 @@
+/**
+ * @file
+ *
+ * @brief Header file for spriteBatch.cpp
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPRITE_BATCH_H
+#define SPRITE_BATCH_H
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <SDL.h>
+
+#include "global.h"
+#include "textureAtlas.h"
+
+class SpriteBatch
+{
+    public:
+
+        // Constructor
+        // Sprite sheets found in atlas are drawn from the atlas (may be NULL)
+        SpriteBatch(const TextureAtlas* atlas);
+
+        // Destructor
+        ~SpriteBatch();
+
+        // Queue a sprite, clip is the part of texture to draw to dst (world
+        // coordinates). Lower layers are drawn first, invisible sprites culled
+        void draw(SDL_Texture* texture, const SDL_Rect& clip, const SDL_Rect& dst, int layer);
+
+        // Draw everything queued, sorted by layer and texture, and empty the queue
+        void flush();
+
+        // Set world position shown at the top left corner of the viewport
+        void setCamera(int x, int y);
+
+        // Get world position shown at the top left corner of the viewport
+        std::pair<int, int> getCamera() const;
+
+        // Set part of the screen drawn to
+        void setViewport(const SDL_Rect& viewport);
+
+        // Get part of the screen drawn to
+        const SDL_Rect& getViewport() const;
+
+        // Set how a layer follows the camera: parallax 1 scrolls with it,
+        // 0 not at all. The offset moves the whole layer on screen
+        void setLayer(int layer, float parallaxX, float parallaxY, int offsetX = 0, int offsetY = 0);
+
+        // Check whether a sprite at dst (world coordinates) would be visible
+        bool isVisible(const SDL_Rect& dst, int layer);
+
+        // Get part of the world a layer shows in the viewport
+        SDL_Rect getView(int layer);
+
+        // Get number of sprites drawn by the last flush
+        unsigned int getNSprites() const;
+
+        // Get number of sprites culled, i.e. queued but not drawn, by the last flush
+        unsigned int getNCulled() const;
+
+        // Get number of render calls issued by the last flush
+        unsigned int getNDrawCalls() const;
+
+    private:
+        //@{
+        /*
+            Queued sprites
+            mTexture  - texture to draw from
+            mClip     - part of the texture to draw
+            mDst      - where to draw it
+            mLayer    - layer of the sprite
+            mOrder    - queue indices, sorted on flush
+         */
+        std::vector<SDL_Texture*> mTexture;
+        std::vector<SDL_Rect> mClip, mDst;
+        std::vector<int> mLayer;
+        std::vector<unsigned int> mOrder;
+        //@}
+
+        //@{
+        /*
+            mAtlas      - atlas sprite sheets are looked up in
+            mVertices   - vertex buffer, reused between flushes
+            mIndices    - index buffer, reused between flushes
+            mNSprites   - sprites drawn by the last flush
+            mNDrawCalls - render calls issued by the last flush
+         */
+        const TextureAtlas* mAtlas;
+        std::vector<SDL_Vertex> mVertices;
+        std::vector<int> mIndices;
+        unsigned int mNSprites, mNDrawCalls;
+        //@}
+
+        // How a layer follows the camera
+        struct Layer
+        {
+            float parallaxX, parallaxY;
+            int offsetX, offsetY;
+        };
+
+        //@{
+        /*
+            Camera
+            mCameraX, mCameraY - world position at the viewport's top left
+            mViewport          - part of the screen drawn to
+            mClipToViewport    - clip to the viewport, it is not the whole window
+            mLayers            - layers not simply following the camera
+            mShiftLayer        - layer mShift was computed for
+            mShiftValid        - mShift is up to date
+            mShift             - world to screen translation of mShiftLayer
+            mCulled            - sprites culled since the last flush
+            mNCulled           - sprites culled before the last flush
+         */
+        int mCameraX, mCameraY;
+        SDL_Rect mViewport;
+        bool mClipToViewport;
+        std::map<int, Layer> mLayers;
+        int mShiftLayer;
+        bool mShiftValid;
+        std::pair<int, int> mShift;
+        unsigned int mCulled, mNCulled;
+        //@}
+
+        // Get world to screen translation of a layer
+        const std::pair<int, int>& getShift(int layer);
+
+        // Draw a run of queued sprites which share a texture
+        void drawRun(unsigned int begin, unsigned int end);
+};
+
+#endif
@@ -29,24 +29,30 @@
 #ifndef SPRITE_FUNCTIONS_H
 #define SPRITE_FUNCTIONS_H
 
-#include "sprite.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <utility>
 
-/**
- * @brief Pixel step used in per-pixel collisions
- * Setting it too low will slow down things.
- * Setting it too high will defeat the purpose of
- * using this kind of collision.
- * 
- */
-#define PIXEL_STEP 30
+#include "sprite.h"
 
 // Check for collision
-bool spriteCollision(Sprite sprite_1, Sprite sprite_2);
+bool spriteCollision(const Sprite& sprite_1, const Sprite& sprite_2);
+
+// Check for collision between two masks at given positions and frames
+bool maskCollision(const BitMask* mask1, unsigned int frame_1, int posX_1, int posY_1,
+                   const BitMask* mask2, unsigned int frame_2, int posX_2, int posY_2);
+
+// Check two boxes moving by (dx,dy) over one tick for contact
+// Returns whether they touch and the time of first contact in [0,1]
+std::pair<bool, double> sweptBoxCollision(const SDL_Rect& box1, int dx1, int dy1,
+                                          const SDL_Rect& box2, int dx2, int dy2);
 
-// Get pixel color
-SDL_Color getPixel(SDL_Surface *surface, int x, int y);
+// Check two masks moving from a previous to a current position for collision
+bool sweptMaskCollision(const BitMask* mask1, unsigned int frame_1, int prevX_1, int prevY_1, int posX_1, int posY_1,
+                        const BitMask* mask2, unsigned int frame_2, int prevX_2, int prevY_2, int posX_2, int posY_2);
 
-// Check whether pixel is black
-bool isBlack(SDL_Surface *surface, int x, int y);
+// Get 64 pixels of a mask row, starting at pixel x
+Uint64 getMaskBits(const Uint64* row, int x);
 
 #endif
@@ -0,0 +1,150 @@
+/**
+ * @file
+ *
+ * @brief Header file for spriteManifest.cpp
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPRITE_MANIFEST_H
+#define SPRITE_MANIFEST_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <SDL.h>
+
+#include "global.h"
+#include "mappedFile.h"
+
+/**
+ * @brief First four bytes of a compiled manifest ("EZSM")
+ */
+#define MANIFEST_MAGIC 0x4D535A45
+
+/**
+ * @brief Version of the compiled manifest format
+ */
+#define MANIFEST_VERSION 1
+
+//@{
+/*
+    Compiled manifest layout, every field is a little-endian 32 bit integer:
+    ManifestHeader, nSprites ManifestSprite, nFrames ManifestFrame, then
+    the string table (NUL-terminated strings, referred to by offset).
+ */
+struct ManifestHeader
+{
+    Uint32 magic;
+    Uint32 version;
+    Uint32 nSprites;
+    Uint32 nFrames;
+    Uint32 stringsOffset;
+    Uint32 stringsSize;
+};
+
+struct ManifestSprite
+{
+    Uint32 name;
+    Uint32 sheet;
+    Uint32 mask;
+    Sint32 layer;
+    Uint32 firstFrame;
+    Uint32 nFrames;
+};
+
+struct ManifestFrame
+{
+    Sint32 x, y, w, h;
+    Uint32 duration;
+};
+//@}
+
+class SpriteManifest
+{
+    public:
+
+        // Constructor - maps a compiled manifest, throws if it is not one
+        SpriteManifest(const std::string& filename);
+
+        // Destructor
+        ~SpriteManifest();
+
+        // Get number of sprites
+        unsigned int size() const;
+
+        // Get index of a sprite by name, -1 if there is none
+        int find(const std::string& name) const;
+
+        // Get name of sprite
+        std::string getName(unsigned int i) const;
+
+        // Get path of the sprite sheet of sprite
+        std::string getSheet(unsigned int i) const;
+
+        // Get path of the image the collision mask of sprite is made from
+        std::string getMask(unsigned int i) const;
+
+        // Get layer sprite is drawn on
+        int getLayer(unsigned int i) const;
+
+        // Get number of animation frames of sprite
+        unsigned int getNFrames(unsigned int i) const;
+
+        // Get rectangle of animation frame k of sprite in its sheet
+        SDL_Rect getFrame(unsigned int i, unsigned int k) const;
+
+        // Get number of ticks animation frame k of sprite is shown
+        unsigned int getDuration(unsigned int i, unsigned int k) const;
+
+        // Get ticks of every animation frame of sprite
+        std::vector<unsigned int> getDurations(unsigned int i) const;
+
+    private:
+        //@{
+        /*
+            mFile    - the compiled manifest, paths are relative to its directory
+            mHeader  - header, in mFile
+            mSprites - sprites, in mFile
+            mFrames  - frames, in mFile
+            mStrings - string table, in mFile
+         */
+        MappedFile mFile;
+        const ManifestHeader* mHeader;
+        const ManifestSprite* mSprites;
+        const ManifestFrame* mFrames;
+        const char* mStrings;
+        //@}
+
+        // Check layout of the file, throws if it is broken
+        void validate();
+
+        // Get string at an offset of the string table
+        const char* getString(Uint32 offset) const;
+
+        // Get sprite record, throws if i is out of range
+        const ManifestSprite& getSprite(unsigned int i) const;
+};
+
+#endif
@@ -0,0 +1,101 @@
+/**
+ * @file
+ *
+ * @brief Header file for stateSnapshot.cpp
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STATE_SNAPSHOT_H
+#define STATE_SNAPSHOT_H
+
+#include <vector>
+
+#include <SDL.h>
+
+#include "global.h"
+#include "spriteBatch.h"
+
+class StateSnapshot
+{
+    public:
+
+        // Constructor
+        StateSnapshot();
+
+        // Destructor
+        ~StateSnapshot();
+
+        // Remove all sprites
+        void clear();
+
+        // Add a sprite, with its position in the previous and current tick
+        void add(SDL_Texture* texture, const SDL_Rect& clip, int prevX, int prevY,
+                 int x, int y, int layer);
+
+        // Queue every sprite, interpolated between previous and current tick
+        void draw(SpriteBatch& batch, double alpha) const;
+
+        // Get number of sprites
+        unsigned int size() const;
+
+        // Get time (performance counter) of the tick the snapshot was taken at
+        Uint64 getTime() const;
+
+        // Set time (performance counter) of the tick the snapshot was taken at
+        void setTime(Uint64 time);
+
+        // Get number of ticks run when the snapshot was taken
+        unsigned long getTick() const;
+
+        // Set number of ticks run when the snapshot was taken
+        void setTick(unsigned long tick);
+
+        // Get time of the oldest input applied in the tick, 0 if none
+        Uint64 getInputTime() const;
+
+        // Set time of the oldest input applied in the tick
+        void setInputTime(Uint64 inputTime);
+
+    private:
+        //@{
+        /*
+            mTexture   - texture of every sprite
+            mClip      - part of the texture (also gives the size)
+            mPrevX     - x position in the previous tick
+            mPrevY     - y position in the previous tick
+            mX         - x position in the current tick
+            mY         - y position in the current tick
+            mLayer     - layer of every sprite
+            mTime      - time of the tick
+            mTick      - number of ticks run, this one included
+            mInputTime - time of the oldest input applied in the tick
+         */
+        std::vector<SDL_Texture*> mTexture;
+        std::vector<SDL_Rect> mClip;
+        std::vector<int> mPrevX, mPrevY, mX, mY, mLayer;
+        Uint64 mTime, mInputTime;
+        unsigned long mTick;
+        //@}
+};
+
+#endif
@@ -0,0 +1,94 @@
+/**
+ * @file
+ *
+ * @brief Header file for textureAtlas.cpp
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include <stdio.h>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <SDL.h>
+
+#include "global.h"
+
+/**
+ * @brief Width and height of an atlas page in pixels
+ * 2048 is supported by pretty much every GPU (and the software renderer).
+ */
+#define ATLAS_SIZE 2048
+
+/**
+ * @brief Empty pixels around every image in an atlas page
+ * Keeps linear filtering from bleeding neighbouring images in.
+ */
+#define ATLAS_PADDING 1
+
+class TextureAtlas
+{
+    public:
+
+        // Constructor
+        TextureAtlas();
+
+        // Destructor
+        ~TextureAtlas();
+
+        // Add a sprite sheet to the atlas, must be called before build
+        void add(const std::string& filename);
+
+        // Pack every added sprite sheet into as few textures as possible
+        bool build();
+
+        // Translate a sprite sheet texture and a clip into atlas texture and clip
+        // Returns the sheet itself if it is not in the atlas
+        SDL_Texture* lookup(SDL_Texture* sheet, SDL_Rect& clip) const;
+
+        // Get number of atlas pages
+        unsigned int getNPages() const;
+
+    private:
+        //@{
+        /*
+            mFilenames - sprite sheets added so far
+            mPages     - atlas textures
+            mPage      - page of every sprite sheet texture
+            mOffset    - position of every sprite sheet texture in its page
+            mSheets    - keeps sheets alive, so their pointers stay unique
+         */
+        std::vector<std::string> mFilenames;
+        std::vector< std::shared_ptr<SDL_Texture> > mPages;
+        std::map<SDL_Texture*, unsigned int> mPage;
+        std::map<SDL_Texture*, SDL_Point> mOffset;
+        std::vector< std::shared_ptr<SDL_Texture> > mSheets;
+        //@}
+};
+
+#endif
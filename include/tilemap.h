@@ -0,0 +1,189 @@
+/**
+ * @file
+ *
+ * @brief Header file for tilemap.cpp
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TILEMAP_H
+#define TILEMAP_H
+
+#include <stdio.h>
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <SDL.h>
+
+#include "global.h"
+#include "assetCache.h"
+#include "spriteBatch.h"
+
+/**
+ * @brief Width and height of a chunk in tiles
+ */
+#define TILEMAP_CHUNK_TILES 16
+
+/**
+ * @brief Chunks built ahead of time per frame, around the visible ones
+ */
+#define TILEMAP_PREFETCH 2
+
+/**
+ * @brief Released chunk textures kept for reuse
+ */
+#define TILEMAP_POOL 8
+
+class Tilemap
+{
+    public:
+
+        // Constructor - an empty map
+        Tilemap();
+
+        // Destructor
+        ~Tilemap();
+
+        // Load a map from a text file, false if it could not be loaded
+        bool load(const std::string& filename);
+
+        // Make an empty map of width x height tiles from a tileset image
+        bool create(const std::string& tileset, int tileWidth, int tileHeight, int width, int height);
+
+        // Get tile at a map position, -1 if empty
+        int getTile(int x, int y) const;
+
+        // Set tile at a map position, -1 for none
+        void setTile(int x, int y, int tile);
+
+        // Repeat the map endlessly in both directions
+        void setRepeat(bool repeat);
+
+        // Set sprite batch layer the map is drawn on
+        void setLayer(int layer);
+
+        // Get sprite batch layer the map is drawn on
+        int getLayer() const;
+
+        // Queue the visible part, building and releasing chunks as needed
+        void draw(SpriteBatch& batch);
+
+        // Forget the content of every chunk, e.g. when render targets were lost
+        void invalidate();
+
+        // Get width in tiles
+        int getWidth() const;
+
+        // Get height in tiles
+        int getHeight() const;
+
+        // Get number of chunks with a texture
+        unsigned int getNResident() const;
+
+        // Get number of chunks built so far
+        unsigned long getNBuilt() const;
+
+        // Get number of chunks queued by the last draw
+        unsigned int getNDrawn() const;
+
+    private:
+        // A block of TILEMAP_CHUNK_TILES x TILEMAP_CHUNK_TILES tiles
+        struct Chunk
+        {
+            std::shared_ptr<SDL_Texture> texture;
+            bool dirty;
+            unsigned long used;
+        };
+
+        //@{
+        /*
+            mTileset     - image holding the tiles, in rows
+            mTileWidth   - width of a tile
+            mTileHeight  - height of a tile
+            mColumns     - tiles per row of the tileset
+            mWidth       - width in tiles
+            mHeight      - height in tiles
+            mTiles       - tile of every map position, row by row, -1 if empty
+            mRepeat      - the map repeats endlessly
+            mLayer       - layer drawn on
+            mTargets     - chunks are cached in render targets
+         */
+        std::shared_ptr<SDL_Texture> mTileset;
+        int mTileWidth, mTileHeight;
+        int mColumns;
+        int mWidth, mHeight;
+        std::vector<int> mTiles;
+        bool mRepeat;
+        int mLayer;
+        bool mTargets;
+        //@}
+
+        //@{
+        /*
+            Chunk cache
+            mChunksX    - chunks per row
+            mChunksY    - chunks per column
+            mChunks     - every chunk, row by row
+            mResident   - chunks which have a texture
+            mPool       - released textures, for reuse
+            mFrame      - frames drawn
+            mNBuilt     - chunks built
+            mNDrawn     - chunks queued by the last draw
+            mPrefetched - chunks built ahead of time in the current frame
+         */
+        int mChunksX, mChunksY;
+        std::vector<Chunk> mChunks;
+        std::vector<unsigned int> mResident;
+        std::vector<std::shared_ptr<SDL_Texture> > mPool;
+        unsigned long mFrame;
+        unsigned long mNBuilt;
+        unsigned int mNDrawn;
+        unsigned int mPrefetched;
+        //@}
+
+        // No copies, chunk textures are owned
+        Tilemap(const Tilemap& other);
+        Tilemap& operator=(const Tilemap& other);
+
+        // Visit chunks covering a world rectangle, queueing or prefetching them
+        void visit(SpriteBatch& batch, const SDL_Rect& area, bool visible);
+
+        // Make sure a chunk's texture is up to date, false if it is not
+        bool build(unsigned int chunk);
+
+        // Queue the tiles of a chunk one by one, without render targets
+        void drawTiles(SpriteBatch& batch, unsigned int chunk, int x, int y);
+
+        // Get size of a chunk in pixels, edge chunks may be smaller
+        std::pair<int, int> getChunkSize(unsigned int chunk) const;
+
+        // Release textures of chunks not used in the current frame
+        void evict();
+};
+
+#endif
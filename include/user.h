@@ -39,11 +39,23 @@ class User: public Sprite
     public:
 
         // Constructor
-        User(int width, int height, int nSprites, std::string filename);
+        User(int width, int height, int nSprites, const std::string& filename);
+
+        // Copy constructor - copies share the loaded resources
+        User(const User& other);
+
+        // Move constructor
+        User(User&& other) noexcept;
 
         // Destructor
         ~User();
 
+        // Copy assignment
+        User& operator=(const User& other);
+
+        // Move assignment
+        User& operator=(User&& other) noexcept;
+
         // Get HP
         int getHP();
 
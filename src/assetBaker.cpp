@@ -0,0 +1,303 @@
+/**
+ * @file
+ *
+ * @brief Defines the offline image and collision mask baker
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <SDL.h>
+#include <SDL_image.h>
+
+#include "global.h"
+#include "bitMask.h"
+#include "assetPack.h"
+#include "recordWriter.h"
+#include "spriteManifest.h"
+
+/**
+ * @brief Mask of an image for frames of a given size
+ */
+typedef std::pair<std::string, std::pair<int, int> > MaskKey;
+
+/**
+ * @brief Append zeros to data until its size is a multiple of PACK_ALIGNMENT
+ * @return Offset of whatever is appended next, counting from base
+ */
+static Uint32 align(std::string& data, std::size_t base)
+{
+    while ((base + data.size()) % PACK_ALIGNMENT != 0)
+    {
+        data += '\0';
+    }
+
+    return base + data.size();
+}
+
+/**
+ * @brief Get path relative to a directory
+ * SpriteManifest returns paths with its own directory in front.
+ */
+static std::string getRelative(const std::string& path, const std::string& directory)
+{
+    return path.substr(directory.size() + 1);
+}
+
+/**
+ * @brief Decode an image, once
+ */
+static SDL_Surface* loadImage(std::map<std::string, std::shared_ptr<SDL_Surface> >& images,
+                              const std::string& filename)
+{
+    std::map<std::string, std::shared_ptr<SDL_Surface> >::const_iterator it = images.find(filename);
+    if (it != images.end())
+    {
+        return it->second.get();
+    }
+
+    SDL_Surface* surface = IMG_Load( filename.c_str() );
+    if( surface == NULL )
+    {
+        printf( "Unable to load image %s! SDL_image Error: %s\n", filename.c_str(), IMG_GetError() );
+        return NULL;
+    }
+
+    images[filename] = std::shared_ptr<SDL_Surface>(surface, SDL_FreeSurface);
+    return surface;
+}
+
+/**
+ * @brief Append pixels of an image as the game draws them
+ * Color keyed pixels become fully transparent and color is premultiplied
+ * by alpha, so loading is a plain texture upload and blending is right
+ * at the edges of scaled sprites. Bytes are R, G, B, A.
+ */
+static bool bakePixels(SDL_Surface* surface, std::string& data)
+{
+    SDL_Surface* pixels = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (pixels == NULL)
+    {
+        printf( "Unable to convert image! SDL Error: %s\n", SDL_GetError() );
+        return false;
+    }
+
+    if (SDL_MUSTLOCK(pixels))
+    {
+        SDL_LockSurface(pixels);
+    }
+
+    for (int y = 0; y < pixels->h; y++)
+    {
+        const Uint32* src = (const Uint32*)((const Uint8*)pixels->pixels + y*pixels->pitch);
+        for (int x = 0; x < pixels->w; x++)
+        {
+            Uint8 r, g, b, a;
+            SDL_GetRGBA(src[x], pixels->format, &r, &g, &b, &a);
+
+            bool keyed = (r == COLOR_KEY[0]) && (g == COLOR_KEY[1]) && (b == COLOR_KEY[2]);
+            if (keyed)
+            {
+                a = 0;
+            }
+
+            data += (char)(r*a/255);
+            data += (char)(g*a/255);
+            data += (char)(b*a/255);
+            data += (char)a;
+        }
+    }
+
+    if (SDL_MUSTLOCK(pixels))
+    {
+        SDL_UnlockSurface(pixels);
+    }
+    SDL_FreeSurface(pixels);
+
+    return true;
+}
+
+/**
+ * @brief Append words of a collision mask, little-endian
+ */
+static void bakeMask(const BitMask& mask, std::string& data)
+{
+    for (unsigned int frame = 0; frame < mask.getNFrames(); frame++)
+    {
+        for (int y = 0; y < mask.getHeight(); y++)
+        {
+            const Uint64* row = mask.getRow(frame, y);
+            for (unsigned int w = 0; w < mask.getWordsPerRow(); w++)
+            {
+                Uint64 word = SDL_SwapLE64(row[w]);
+                data.append(reinterpret_cast<const char*>(&word), sizeof(word));
+            }
+        }
+    }
+}
+
+/**
+ * @brief Asset baker
+ *
+ * Usage: engineZBake MANIFEST OUTPUT [IMAGEDIR]
+ *
+ * Bakes the sprite sheets and collision masks of every sprite of a
+ * compiled sprite manifest into one asset pack, read by AssetPack.
+ * Images are read from IMAGEDIR, by default the directory of the
+ * manifest, and are stored under the paths the manifest gives.
+ */
+int main(int argvc, char* argv[])
+{
+    if ((argvc != 3) && (argvc != 4))
+    {
+        printf( "Usage: %s MANIFEST OUTPUT [IMAGEDIR]\n", argv[0] );
+        return 1;
+    }
+
+    std::string manifestPath = argv[1];
+    std::size_t slash        = manifestPath.find_last_of("/\\");
+    std::string directory    = (slash == std::string::npos) ? "." : manifestPath.substr(0, slash);
+    std::string imageDir     = (argvc == 4) ? argv[3] : directory;
+
+    std::unique_ptr<SpriteManifest> manifest;
+    try
+    {
+        manifest.reset(new SpriteManifest(manifestPath));
+    }
+    catch (const std::runtime_error& e)
+    {
+        printf( "%s:%s\n", argv[1], e.what() );
+        return 1;
+    }
+
+    // Every sheet once and every mask once per frame size
+    std::vector<std::string> sheets;
+    std::vector<MaskKey> masks;
+    for (unsigned int i = 0; i < manifest->size(); i++)
+    {
+        std::string sheet = getRelative(manifest->getSheet(i), directory);
+        std::string mask  = getRelative(manifest->getMask(i), directory);
+        SDL_Rect frame    = manifest->getFrame(i, 0);
+
+        MaskKey maskKey   = std::make_pair(mask, std::make_pair(frame.w, frame.h));
+        if (std::find(sheets.begin(), sheets.end(), sheet) == sheets.end())
+        {
+            sheets.push_back(sheet);
+        }
+        if (std::find(masks.begin(), masks.end(), maskKey) == masks.end())
+        {
+            masks.push_back(maskKey);
+        }
+    }
+
+    StringTable strings;
+    std::vector<PackImage> images(sheets.size());
+    std::vector<PackMask> packMasks(masks.size());
+    for (unsigned int i = 0; i < sheets.size(); i++)
+    {
+        images[i].name = strings.add(sheets[i]);
+    }
+    for (unsigned int m = 0; m < masks.size(); m++)
+    {
+        packMasks[m].name = strings.add(masks[m].first);
+    }
+
+    PackHeader header;
+    header.magic         = PACK_MAGIC;
+    header.version       = PACK_VERSION;
+    header.nImages       = images.size();
+    header.nMasks        = packMasks.size();
+    header.stringsOffset = sizeof(PackHeader) + images.size()*sizeof(PackImage)
+                         + packMasks.size()*sizeof(PackMask);
+    header.stringsSize   = strings.data.size() + 1;
+
+    // Pixels and masks follow the string table
+    std::size_t dataOffset = header.stringsOffset + header.stringsSize;
+    std::string data;
+    std::map<std::string, std::shared_ptr<SDL_Surface> > decoded;
+
+    for (unsigned int i = 0; i < sheets.size(); i++)
+    {
+        SDL_Surface* surface = loadImage(decoded, imageDir + "/" + sheets[i]);
+        images[i].width  = (surface != NULL) ? surface->w : 0;
+        images[i].height = (surface != NULL) ? surface->h : 0;
+        images[i].pixels = align(data, dataOffset);
+        if ((surface == NULL) || !bakePixels(surface, data))
+        {
+            return 1;
+        }
+    }
+
+    for (unsigned int m = 0; m < masks.size(); m++)
+    {
+        SDL_Surface* surface = loadImage(decoded, imageDir + "/" + masks[m].first);
+        if (surface == NULL)
+        {
+            return 1;
+        }
+
+        BitMask mask(surface, masks[m].second.first, masks[m].second.second);
+        packMasks[m].width       = mask.getWidth();
+        packMasks[m].height      = mask.getHeight();
+        packMasks[m].nFrames     = mask.getNFrames();
+        packMasks[m].wordsPerRow = mask.getWordsPerRow();
+        packMasks[m].bits        = align(data, dataOffset);
+        bakeMask(mask, data);
+    }
+
+    FILE* output = fopen(argv[2], "wb");
+    if (output == NULL)
+    {
+        printf( "Could not create %s!\n", argv[2] );
+        return 1;
+    }
+
+    // Every record is made of 32 bit words only
+    bool ok = writeWords(output, reinterpret_cast<const Uint32*>(&header), sizeof(header)/4);
+    for (unsigned int i = 0; ok && (i < images.size()); i++)
+    {
+        ok = writeWords(output, reinterpret_cast<const Uint32*>(&images[i]), sizeof(PackImage)/4);
+    }
+    for (unsigned int m = 0; ok && (m < packMasks.size()); m++)
+    {
+        ok = writeWords(output, reinterpret_cast<const Uint32*>(&packMasks[m]), sizeof(PackMask)/4);
+    }
+    ok = ok && (fwrite(strings.data.c_str(), strings.data.size() + 1, 1, output) == 1);
+    ok = ok && (data.empty() || (fwrite(data.data(), data.size(), 1, output) == 1));
+
+    if ((fclose(output) != 0) || !ok)
+    {
+        printf( "Could not write %s!\n", argv[2] );
+        remove(argv[2]);
+        return 1;
+    }
+
+    return 0;
+}
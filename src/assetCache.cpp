@@ -0,0 +1,449 @@
+/**
+ * @file
+ *
+ * @brief Defines a reference counted cache for textures and collision masks
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "assetCache.h"
+
+// Assets shared by every sprite
+AssetCache assetCache;
+
+/**
+ * @brief Blend textures holding premultiplied alpha
+ * color = src + dst*(1 - srcAlpha). Renderers without custom blend modes
+ * (e.g. the software one, or SDL older than 2.0.6) fall back to ordinary
+ * alpha blending, which is only off for partly transparent pixels.
+ */
+void setPremultipliedBlendMode(SDL_Texture* texture)
+{
+#if SDL_VERSION_ATLEAST(2, 0, 6)
+    SDL_BlendMode premultiplied = SDL_ComposeCustomBlendMode(
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+    if (SDL_SetTextureBlendMode(texture, premultiplied) == 0)
+    {
+        return;
+    }
+#endif
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+}
+
+/**
+ * @brief Frees a surface whose pixels are in an asset pack
+ * Holds the pack, so it stays mapped as long as the surface is used.
+ */
+struct BakedSurfaceDeleter
+{
+    std::shared_ptr<AssetPack> pack;
+
+    void operator()(SDL_Surface* surface) const
+    {
+        SDL_FreeSurface(surface);
+    }
+};
+
+/**
+ * @class Cache for image assets. Every image is decoded once and the
+ * resulting texture and mask are handed out as shared handles, so that
+ * creating a sprite from an already loaded file does not touch the disk.
+ *
+ * With an asset pack loaded (see loadPack) images and masks baked into it
+ * are not decoded at all, they are uploaded and copied as they are.
+ */
+AssetCache::AssetCache()
+{
+    mHits          = 0;
+    mMisses        = 0;
+    mBytesResident = 0;
+}
+
+// Destructor
+AssetCache::~AssetCache()
+{
+    clear();
+}
+
+/**
+ * @brief Get sprite sheet texture
+ * The image is loaded on first use. Returns an empty pointer if it
+ * could not be loaded.
+ */
+std::shared_ptr<SDL_Texture> AssetCache::getTexture(const std::string& filename)
+{
+    const Asset* asset = find(filename);
+    if (asset == NULL)
+    {
+        return std::shared_ptr<SDL_Texture>();
+    }
+
+    return asset->texture;
+}
+
+/**
+ * @brief Get decoded image
+ * The surface has the color key set. Returns an empty pointer if it
+ * could not be loaded.
+ */
+std::shared_ptr<SDL_Surface> AssetCache::getSurface(const std::string& filename)
+{
+    const Asset* asset = find(filename);
+    if (asset == NULL)
+    {
+        return std::shared_ptr<SDL_Surface>();
+    }
+
+    return asset->surface;
+}
+
+/**
+ * @brief Get collision mask
+ * The image is loaded on first use and the mask for a given frame size
+ * is built once from it. Returns an empty pointer if the image could not
+ * be loaded.
+ */
+std::shared_ptr<BitMask> AssetCache::getMask(const std::string& filename, int width, int height)
+{
+    Asset* asset = find(filename);
+    if (asset == NULL)
+    {
+        return std::shared_ptr<BitMask>();
+    }
+
+    std::pair<int, int> size = std::make_pair(width, height);
+    std::map<std::pair<int, int>, std::shared_ptr<BitMask> >::iterator it = asset->masks.find(size);
+    if (it != asset->masks.end())
+    {
+        return it->second;
+    }
+
+    std::shared_ptr<BitMask> mask;
+    int baked = (mPack != NULL) ? mPack->findMask(filename, width, height) : -1;
+    if (baked >= 0)
+    {
+        mask.reset(new BitMask(width, height, mPack->getNFrames(baked), mPack->getBits(baked)));
+    }
+    else
+    {
+        mask.reset(new BitMask(asset->surface.get(), width, height));
+    }
+    asset->masks[size] = mask;
+    asset->bytes      += mask->getBytes();
+    mBytesResident    += mask->getBytes();
+
+    return mask;
+}
+
+/**
+ * @brief Check whether image pixels are premultiplied by alpha
+ * Baked images are, decoded ones are not. The image is loaded on first use.
+ */
+bool AssetCache::isPremultiplied(const std::string& filename)
+{
+    const Asset* asset = find(filename);
+
+    return (asset != NULL) && asset->premultiplied;
+}
+
+/**
+ * @brief Use images and masks baked into an asset pack
+ * Images and masks loaded after this come from the pack where it has
+ * them and are decoded from their files as before otherwise. Assets
+ * already loaded are kept.
+ * @return false if the pack could not be loaded, assets are then decoded
+ */
+bool AssetCache::loadPack(const std::string& filename)
+{
+    try
+    {
+        mPack = std::make_shared<AssetPack>(filename);
+    }
+    catch (const std::runtime_error& e)
+    {
+        printf( "Unable to load asset pack, images will be decoded!%s\n", e.what() );
+        mPack.reset();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Add an image decoded elsewhere (see decode)
+ * Uploads it as if it had been loaded on first use, so later lookups are
+ * hits. Takes ownership of the surface; it is freed if the image is
+ * already cached or the upload fails.
+ */
+bool AssetCache::add(const std::string& filename, SDL_Surface* surface)
+{
+    if (isLoaded(filename))
+    {
+        SDL_FreeSurface(surface);
+        return true;
+    }
+
+    Asset asset;
+    if (!upload(filename, surface, asset))
+    {
+        return false;
+    }
+
+    mBytesResident += asset.bytes;
+    mAssets[getKey(filename)] = asset;
+
+    return true;
+}
+
+/**
+ * @brief Check whether an image is cached
+ * Unlike the getters this never loads it.
+ */
+bool AssetCache::isLoaded(const std::string& filename) const
+{
+    return mAssets.find(getKey(filename)) != mAssets.end();
+}
+
+/**
+ * @brief Check whether an image is in the asset pack
+ * Baked images need no decoding, loading them is only an upload.
+ */
+bool AssetCache::isBaked(const std::string& filename) const
+{
+    return (mPack != NULL) && (mPack->findImage(filename) >= 0);
+}
+
+/**
+ * @brief Release assets which are only referenced by the cache
+ * @return Number of released assets
+ */
+unsigned int AssetCache::purge()
+{
+    unsigned int released = 0;
+
+    std::map<AssetKey, Asset>::iterator it = mAssets.begin();
+    while (it != mAssets.end())
+    {
+        bool used = (it->second.texture.use_count() > 1) || (it->second.surface.use_count() > 1);
+
+        std::map<std::pair<int, int>, std::shared_ptr<BitMask> >::iterator mask;
+        for (mask = it->second.masks.begin(); mask != it->second.masks.end(); ++mask)
+        {
+            used = used || (mask->second.use_count() > 1);
+        }
+
+        if (!used)
+        {
+            mBytesResident -= it->second.bytes;
+            it = mAssets.erase(it);
+            released++;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    return released;
+}
+
+/**
+ * @brief Release all assets
+ * Sprites still holding a handle keep their asset alive until they are
+ * destroyed.
+ */
+void AssetCache::clear()
+{
+    mAssets.clear();
+    mBytesResident = 0;
+}
+
+/**
+ * @brief Get number of lookups served from the cache
+ */
+unsigned long AssetCache::getHits() const
+{
+    return mHits;
+}
+
+/**
+ * @brief Get number of lookups which had to load from disk
+ */
+unsigned long AssetCache::getMisses() const
+{
+    return mMisses;
+}
+
+/**
+ * @brief Get number of bytes held by cached assets
+ * Texture size is estimated as 4 bytes per pixel. Collision masks are
+ * included.
+ */
+std::size_t AssetCache::getBytesResident() const
+{
+    return mBytesResident;
+}
+
+/**
+ * @brief Find asset, loading it if it is not cached yet
+ * @return A pointer to the asset or NULL if it could not be loaded
+ */
+AssetCache::Asset* AssetCache::find(const std::string& filename)
+{
+    std::map<AssetKey, Asset>::iterator it = mAssets.find(getKey(filename));
+    if (it != mAssets.end())
+    {
+        mHits++;
+        return &it->second;
+    }
+
+    mMisses++;
+
+    // Failed loads are not cached, so the file is retried next time
+    Asset asset;
+    int baked = (mPack != NULL) ? mPack->findImage(filename) : -1;
+    if (!((baked >= 0) ? loadBaked(filename, baked, asset) : load(filename, asset)))
+    {
+        return NULL;
+    }
+
+    mBytesResident += asset.bytes;
+    return &(mAssets[getKey(filename)] = asset);
+}
+
+/**
+ * @brief Get key of an image
+ * The color key is part of it, the same file keyed differently is a
+ * different asset.
+ */
+AssetCache::AssetKey AssetCache::getKey(const std::string& filename)
+{
+    Uint32 colorKey = (COLOR_KEY[0] << 16) | (COLOR_KEY[1] << 8) | COLOR_KEY[2];
+
+    return std::make_pair(filename, colorKey);
+}
+
+/**
+ * @brief Load asset from disk
+ * The image is decoded only once. The decoded surface is uploaded as the
+ * sprite sheet texture and kept to build collision masks from.
+ */
+bool AssetCache::load(const std::string& filename, Asset& asset)
+{
+    SDL_Surface* surface = decode(filename);
+    if( surface == NULL )
+    {
+        return false;
+    }
+
+    return upload(filename, surface, asset);
+}
+
+/**
+ * @brief Decode image and set its color key
+ * Touches neither the cache nor the renderer, so it may run on any thread.
+ * @return The surface, owned by the caller, or NULL if it could not be loaded
+ */
+SDL_Surface* AssetCache::decode(const std::string& filename)
+{
+    SDL_Surface* surface = IMG_Load( filename.c_str() );
+    if( surface == NULL )
+    {
+        printf( "Unable to load image %s! SDL_image Error: %s\n", filename.c_str(), IMG_GetError() );
+        return NULL;
+    }
+
+    //Set color key (for transparency)
+    SDL_SetColorKey( surface, SDL_TRUE, SDL_MapRGB( surface->format, COLOR_KEY[0],
+                     COLOR_KEY[1], COLOR_KEY[2] ) );
+
+    return surface;
+}
+
+/**
+ * @brief Upload a decoded surface as the sprite sheet texture
+ * Takes ownership of the surface, it is freed if the upload fails.
+ */
+bool AssetCache::upload(const std::string& filename, SDL_Surface* surface, Asset& asset)
+{
+    //Create texture from surface
+    SDL_Texture* texture = SDL_CreateTextureFromSurface( renderer, surface );
+    if( texture == NULL )
+    {
+        printf( "Unable to create texture from %s! SDL Error: %s\n", filename.c_str(), SDL_GetError() );
+        SDL_FreeSurface( surface );
+        return false;
+    }
+
+    asset.texture = std::shared_ptr<SDL_Texture>(texture, SDL_DestroyTexture);
+    asset.surface = std::shared_ptr<SDL_Surface>(surface, SDL_FreeSurface);
+    asset.bytes   = surface->pitch*surface->h + surface->w*surface->h*4;
+    asset.premultiplied = false;
+
+    return true;
+}
+
+/**
+ * @brief Load asset from the asset pack
+ * Pixels are uploaded as they are. The surface refers to the pixels in
+ * the pack, so it is read only and keeps the pack alive.
+ */
+bool AssetCache::loadBaked(const std::string& filename, unsigned int image, Asset& asset)
+{
+    int width  = mPack->getWidth(image);
+    int height = mPack->getHeight(image);
+    void* pixels = const_cast<void*>(mPack->getPixels(image));
+
+    SDL_Texture* texture = SDL_CreateTexture( renderer, PACK_PIXEL_FORMAT, SDL_TEXTUREACCESS_STATIC,
+                                              width, height );
+    if( (texture == NULL) || (SDL_UpdateTexture( texture, NULL, pixels, width*4 ) != 0) )
+    {
+        printf( "Unable to create texture from %s! SDL Error: %s\n", filename.c_str(), SDL_GetError() );
+        if( texture != NULL )
+        {
+            SDL_DestroyTexture( texture );
+        }
+        return false;
+    }
+    setPremultipliedBlendMode( texture );
+
+    int bpp;
+    Uint32 rMask, gMask, bMask, aMask;
+    SDL_PixelFormatEnumToMasks( PACK_PIXEL_FORMAT, &bpp, &rMask, &gMask, &bMask, &aMask );
+    SDL_Surface* surface = SDL_CreateRGBSurfaceFrom( pixels, width, height, bpp, width*4,
+                                                     rMask, gMask, bMask, aMask );
+    if( surface == NULL )
+    {
+        printf( "Unable to create surface from %s! SDL Error: %s\n", filename.c_str(), SDL_GetError() );
+        SDL_DestroyTexture( texture );
+        return false;
+    }
+
+    BakedSurfaceDeleter deleter = { mPack };
+    asset.texture = std::shared_ptr<SDL_Texture>(texture, SDL_DestroyTexture);
+    asset.surface = std::shared_ptr<SDL_Surface>(surface, deleter);
+    asset.bytes   = width*height*4;
+    asset.premultiplied = true;
+
+    return true;
+}
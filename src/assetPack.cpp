@@ -0,0 +1,249 @@
+/**
+ * @file
+ *
+ * @brief Defines baked image and collision mask packs
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "assetPack.h"
+
+/**
+ * @class Images and collision masks baked offline by engineZBake, in the
+ * form they are used in: pixels are premultiplied RGBA with the color key
+ * already applied, masks are packed BitMask words. The pack is mapped
+ * into memory, so loading an image is a texture upload and loading a
+ * mask a copy, nothing is decoded or converted.
+ */
+AssetPack::AssetPack(const std::string& filename)
+    :mFile(filename)
+{
+    validate();
+}
+
+// Destructor
+AssetPack::~AssetPack()
+{
+
+}
+
+/**
+ * @brief Get index of an image
+ * The path is the one images are loaded by, i.e. it includes the
+ * directory of the pack.
+ */
+int AssetPack::findImage(const std::string& filename) const
+{
+    std::string name = getRelative(filename);
+    for (unsigned int i = 0; i < SDL_SwapLE32(mHeader->nImages); i++)
+    {
+        if (name == mStrings + SDL_SwapLE32(mImages[i].name))
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Get index of the mask of an image for frames of a given size
+ */
+int AssetPack::findMask(const std::string& filename, int width, int height) const
+{
+    std::string name = getRelative(filename);
+    for (unsigned int m = 0; m < SDL_SwapLE32(mHeader->nMasks); m++)
+    {
+        if (((Sint32)SDL_SwapLE32(mMasks[m].width) == width) &&
+            ((Sint32)SDL_SwapLE32(mMasks[m].height) == height) &&
+            (name == mStrings + SDL_SwapLE32(mMasks[m].name)))
+        {
+            return m;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Get width of image
+ */
+int AssetPack::getWidth(unsigned int i) const
+{
+    return (Sint32)SDL_SwapLE32(getImage(i).width);
+}
+
+/**
+ * @brief Get height of image
+ */
+int AssetPack::getHeight(unsigned int i) const
+{
+    return (Sint32)SDL_SwapLE32(getImage(i).height);
+}
+
+/**
+ * @brief Get pixels of image
+ * Rows are width*4 bytes, in PACK_PIXEL_FORMAT. The memory is read only.
+ */
+const void* AssetPack::getPixels(unsigned int i) const
+{
+    return mFile.getData() + SDL_SwapLE32(getImage(i).pixels);
+}
+
+/**
+ * @brief Get number of frames of mask
+ */
+unsigned int AssetPack::getNFrames(unsigned int m) const
+{
+    return SDL_SwapLE32(getMask(m).nFrames);
+}
+
+/**
+ * @brief Get number of 64 bit words per row of mask, including the padding word
+ */
+unsigned int AssetPack::getWordsPerRow(unsigned int m) const
+{
+    return SDL_SwapLE32(getMask(m).wordsPerRow);
+}
+
+/**
+ * @brief Get words of mask
+ * Laid out as in BitMask, but always little-endian.
+ */
+const Uint64* AssetPack::getBits(unsigned int m) const
+{
+    return reinterpret_cast<const Uint64*>(mFile.getData() + SDL_SwapLE32(getMask(m).bits));
+}
+
+/**
+ * @brief Check layout of the file
+ * Everything referred to must lie inside the file, so that accessors do
+ * not need to check again.
+ */
+void AssetPack::validate()
+{
+    const unsigned char* data = mFile.getData();
+    std::size_t size          = mFile.getSize();
+
+    if (size < sizeof(PackHeader))
+    {
+        throw std::runtime_error(" Asset pack is truncated!");
+    }
+
+    mHeader = reinterpret_cast<const PackHeader*>(data);
+    if ((SDL_SwapLE32(mHeader->magic) != PACK_MAGIC) ||
+        (SDL_SwapLE32(mHeader->version) != PACK_VERSION))
+    {
+        throw std::runtime_error(" Not an asset pack, or an old one!");
+    }
+
+    std::size_t nImages       = SDL_SwapLE32(mHeader->nImages);
+    std::size_t nMasks        = SDL_SwapLE32(mHeader->nMasks);
+    std::size_t stringsOffset = SDL_SwapLE32(mHeader->stringsOffset);
+    std::size_t stringsSize   = SDL_SwapLE32(mHeader->stringsSize);
+    std::size_t masksOffset   = sizeof(PackHeader) + nImages*sizeof(PackImage);
+
+    if ((masksOffset + nMasks*sizeof(PackMask) > stringsOffset) ||
+        (stringsOffset + stringsSize > size) ||
+        (0 == stringsSize) || (data[stringsOffset + stringsSize - 1] != 0))
+    {
+        throw std::runtime_error(" Asset pack is corrupt!");
+    }
+
+    mImages  = reinterpret_cast<const PackImage*>(data + sizeof(PackHeader));
+    mMasks   = reinterpret_cast<const PackMask*>(data + masksOffset);
+    mStrings = reinterpret_cast<const char*>(data + stringsOffset);
+
+    for (std::size_t i = 0; i < nImages; i++)
+    {
+        const PackImage& image = mImages[i];
+        std::size_t width  = (Sint32)SDL_SwapLE32(image.width);
+        std::size_t height = (Sint32)SDL_SwapLE32(image.height);
+        std::size_t pixels = SDL_SwapLE32(image.pixels);
+        if ((SDL_SwapLE32(image.name) >= stringsSize) ||
+            ((Sint32)SDL_SwapLE32(image.width) <= 0) || ((Sint32)SDL_SwapLE32(image.height) <= 0) ||
+            (pixels % PACK_ALIGNMENT != 0) || (pixels > size) ||
+            (width*height*4 > size - pixels))
+        {
+            throw std::runtime_error(" Asset pack is corrupt!");
+        }
+    }
+
+    for (std::size_t m = 0; m < nMasks; m++)
+    {
+        const PackMask& mask = mMasks[m];
+        std::size_t height      = (Sint32)SDL_SwapLE32(mask.height);
+        std::size_t nFrames     = SDL_SwapLE32(mask.nFrames);
+        std::size_t wordsPerRow = SDL_SwapLE32(mask.wordsPerRow);
+        std::size_t bits        = SDL_SwapLE32(mask.bits);
+        if ((SDL_SwapLE32(mask.name) >= stringsSize) ||
+            ((Sint32)SDL_SwapLE32(mask.width) <= 0) || ((Sint32)SDL_SwapLE32(mask.height) <= 0) ||
+            (0 == nFrames) ||
+            (wordsPerRow != (std::size_t)((Sint32)SDL_SwapLE32(mask.width) + 63)/64 + 1) ||
+            (bits % PACK_ALIGNMENT != 0) || (bits > size) ||
+            (nFrames*height*wordsPerRow*sizeof(Uint64) > size - bits))
+        {
+            throw std::runtime_error(" Asset pack is corrupt!");
+        }
+    }
+}
+
+/**
+ * @brief Get path relative to the directory of the pack
+ * Paths outside of it are returned as they are and match nothing.
+ */
+std::string AssetPack::getRelative(const std::string& filename) const
+{
+    std::string directory = mFile.getDirectory() + "/";
+    if (filename.compare(0, directory.size(), directory) == 0)
+    {
+        return filename.substr(directory.size());
+    }
+
+    return filename;
+}
+
+/**
+ * @brief Get image record
+ */
+const PackImage& AssetPack::getImage(unsigned int i) const
+{
+    if (i >= SDL_SwapLE32(mHeader->nImages))
+    {
+        throw std::out_of_range(" Unknown image!");
+    }
+
+    return mImages[i];
+}
+
+/**
+ * @brief Get mask record
+ */
+const PackMask& AssetPack::getMask(unsigned int m) const
+{
+    if (m >= SDL_SwapLE32(mHeader->nMasks))
+    {
+        throw std::out_of_range(" Unknown mask!");
+    }
+
+    return mMasks[m];
+}
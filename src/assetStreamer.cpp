@@ -0,0 +1,328 @@
+/**
+ * @file
+ *
+ * @brief Defines background loading of images and music
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "assetStreamer.h"
+
+/**
+ * @class Loads images and music in the background, so that requesting an
+ * asset ahead of need does not stall a frame.
+ *
+ * Loader threads decode images (and set their color key) and load music.
+ * Textures can only be created on the render thread, so decoded images
+ * wait until update uploads them into the asset cache, a few per frame
+ * within a time budget. Once a request is ready, the asset is a cache hit
+ * for everyone, e.g. a Sprite created from the same file. Images baked
+ * into the asset pack skip the loader threads, they only need the upload.
+ *
+ * Requests return a handle to poll instead of a future: an image is only
+ * done once the render thread uploaded it, so blocking on it there would
+ * never return. Requests and update are made from the render thread.
+ */
+AssetStreamer::AssetStreamer(unsigned int nThreads)
+    :mQuit(false)
+{
+    // Nothing would ever be decoded without one
+    nThreads = std::max(nThreads, 1u);
+    for (unsigned int i = 0; i < nThreads; i++)
+    {
+        mThreads.push_back(std::thread(&AssetStreamer::run, this));
+    }
+}
+
+/**
+ * @brief Destructor - stops loader threads
+ * A loader thread busy with an asset finishes it first. Streamed music
+ * is freed here, so the streamer must go before the audio device is
+ * closed.
+ */
+AssetStreamer::~AssetStreamer()
+{
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        mQuit = true;
+    }
+    mWake.notify_all();
+
+    for (unsigned int i = 0; i < mThreads.size(); i++)
+    {
+        mThreads[i].join();
+    }
+
+    for (unsigned int i = 0; i < mRequests.size(); i++)
+    {
+        SDL_FreeSurface(mRequests[i].surface);
+    }
+}
+
+/**
+ * @brief Request image to be loaded into the asset cache
+ * Requesting an image which is already cached or requested again is
+ * cheap and returns a ready or the earlier handle.
+ */
+StreamHandle AssetStreamer::requestImage(const std::string& filename)
+{
+    return request(filename, false);
+}
+
+/**
+ * @brief Request music to be loaded
+ * Music is not cached, get it from the handle once it is ready. It is
+ * loaded completely on a loader thread, SDL_mixer only needs the render
+ * thread to play it.
+ */
+StreamHandle AssetStreamer::requestMusic(const std::string& filename)
+{
+    return request(filename, true);
+}
+
+/**
+ * @brief Get progress of a request
+ */
+StreamStatus AssetStreamer::getStatus(StreamHandle handle) const
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+
+    return getRequest(handle).status;
+}
+
+/**
+ * @brief Check whether a request is done and usable
+ */
+bool AssetStreamer::isReady(StreamHandle handle) const
+{
+    return getStatus(handle) == STREAM_READY;
+}
+
+/**
+ * @brief Get texture of a ready image request
+ * The streamer holds it, so purging the cache does not drop it.
+ */
+std::shared_ptr<SDL_Texture> AssetStreamer::getTexture(StreamHandle handle) const
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+
+    return getRequest(handle).texture;
+}
+
+/**
+ * @brief Get ready music
+ */
+std::shared_ptr<Mix_Music> AssetStreamer::getMusic(StreamHandle handle) const
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+
+    return getRequest(handle).track;
+}
+
+/**
+ * @brief Upload decoded images
+ * Called once per frame on the render thread. At least one image is
+ * uploaded per call, so large images still get through, and no more once
+ * budget ms have passed.
+ * @return Number of images uploaded
+ */
+unsigned int AssetStreamer::update(double budget)
+{
+    Uint64 start     = SDL_GetPerformanceCounter();
+    Uint64 limit     = budget*SDL_GetPerformanceFrequency()/1000.0;
+    unsigned int nUploads = 0;
+
+    while ((0 == nUploads) || (SDL_GetPerformanceCounter() - start < limit))
+    {
+        StreamHandle handle;
+        std::string filename;
+        SDL_Surface* surface;
+        {
+            std::lock_guard<std::mutex> guard(mMutex);
+            if (mUploads.empty())
+            {
+                break;
+            }
+
+            handle   = mUploads.front();
+            filename = mRequests[handle].filename;
+            surface  = mRequests[handle].surface;
+            mUploads.pop_front();
+            mRequests[handle].surface = NULL;
+        }
+
+        // Baked images come without a surface, the cache uploads them
+        bool ok = (surface == NULL) || assetCache.add(filename, surface);
+        std::shared_ptr<SDL_Texture> texture;
+        if (ok)
+        {
+            texture = assetCache.getTexture(filename);
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(mMutex);
+            mRequests[handle].texture = texture;
+            mRequests[handle].status  = (texture != NULL) ? STREAM_READY : STREAM_FAILED;
+        }
+        nUploads++;
+    }
+
+    return nUploads;
+}
+
+/**
+ * @brief Get number of requests not done yet
+ */
+unsigned int AssetStreamer::getPending() const
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+
+    unsigned int pending = 0;
+    for (unsigned int i = 0; i < mRequests.size(); i++)
+    {
+        if ((mRequests[i].status == STREAM_QUEUED) || (mRequests[i].status == STREAM_DECODED))
+        {
+            pending++;
+        }
+    }
+
+    return pending;
+}
+
+/**
+ * @brief Add a request
+ * Images which need no decoding go straight to the upload queue.
+ */
+StreamHandle AssetStreamer::request(const std::string& filename, bool music)
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+
+    std::pair<std::string, bool> key = std::make_pair(filename, music);
+    std::map<std::pair<std::string, bool>, StreamHandle>::const_iterator it = mHandles.find(key);
+    if (it != mHandles.end())
+    {
+        return it->second;
+    }
+
+    Request request;
+    request.filename = filename;
+    request.music    = music;
+    request.status   = STREAM_QUEUED;
+    request.surface  = NULL;
+
+    StreamHandle handle = mRequests.size();
+    if (!music && assetCache.isLoaded(filename))
+    {
+        request.status  = STREAM_READY;
+        request.texture = assetCache.getTexture(filename);
+    }
+    else if (!music && assetCache.isBaked(filename))
+    {
+        request.status = STREAM_DECODED;
+        mUploads.push_back(handle);
+    }
+    else
+    {
+        mDecodes.push_back(handle);
+    }
+
+    mRequests.push_back(request);
+    mHandles[key] = handle;
+    mWake.notify_one();
+
+    return handle;
+}
+
+/**
+ * @brief Get request
+ */
+const AssetStreamer::Request& AssetStreamer::getRequest(StreamHandle handle) const
+{
+    if (handle >= mRequests.size())
+    {
+        throw std::out_of_range(" Unknown asset request!");
+    }
+
+    return mRequests[handle];
+}
+
+/**
+ * @brief Loader thread main loop
+ * Decoding happens outside the lock, so requests, polls and uploads are
+ * never held up by it.
+ */
+void AssetStreamer::run()
+{
+    std::unique_lock<std::mutex> guard(mMutex);
+
+    while (true)
+    {
+        mWake.wait(guard, [this]{ return !mDecodes.empty() || mQuit; });
+        if (mQuit)
+        {
+            return;
+        }
+
+        StreamHandle handle  = mDecodes.front();
+        std::string filename = mRequests[handle].filename;
+        bool music           = mRequests[handle].music;
+        mDecodes.pop_front();
+
+        guard.unlock();
+        SDL_Surface* surface = NULL;
+        std::shared_ptr<Mix_Music> track;
+        if (music)
+        {
+            Mix_Music* loaded = Mix_LoadMUS( filename.c_str() );
+            if( loaded == NULL )
+            {
+                printf( "Failed to load music %s! SDL_mixer Error: %s\n", filename.c_str(), Mix_GetError() );
+            }
+            else
+            {
+                track = std::shared_ptr<Mix_Music>(loaded, Mix_FreeMusic);
+            }
+        }
+        else
+        {
+            surface = AssetCache::decode(filename);
+        }
+        guard.lock();
+
+        Request& request = mRequests[handle];
+        if (music)
+        {
+            request.track  = track;
+            request.status = (track != NULL) ? STREAM_READY : STREAM_FAILED;
+        }
+        else if (surface == NULL)
+        {
+            request.status = STREAM_FAILED;
+        }
+        else
+        {
+            request.surface = surface;
+            request.status  = STREAM_DECODED;
+            mUploads.push_back(handle);
+        }
+    }
+}
@@ -0,0 +1,275 @@
+/**
+ * @file
+ *
+ * @brief Defines sound effect banks and voice pooling
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audio.h"
+
+/**
+ * @class Sound effects and music. Sounds are decoded once into a bank
+ * when loaded, so playing one never touches the disk or a decoder.
+ *
+ * Sounds play on a fixed pool of voices (SDL_mixer channels). When all
+ * are busy a new sound steals the voice of the lowest priority sound not
+ * above its own, the oldest one among equals, and is dropped if there is
+ * none. A sound plays on at most maxInstances voices at once, beyond that
+ * it takes over its own oldest voice. Starting a sound again within one
+ * mixer buffer is dropped: both would start at the same sample, which only
+ * adds gain. So hundreds of hits per frame cost a handful of voices and
+ * the mixer load stays bounded.
+ *
+ * The mixer buffer size is AUDIO_BUFFER, smaller means lower latency but
+ * more risk of underruns. Music is decoded by SDL_mixer as it plays, on
+ * the audio thread; load it with AssetStreamer so opening it does not
+ * stall either.
+ *
+ * Without an audio device (headless) everything is accepted and nothing
+ * plays. Must be used from one thread only.
+ */
+Audio::Audio(unsigned int nVoices)
+    :mBufferTime(0),
+     mPlayed(0),
+     mStolen(0),
+     mDropped(0)
+{
+    int frequency, channels;
+    Uint16 format;
+    mOpen = (Mix_QuerySpec(&frequency, &format, &channels) != 0);
+
+    if (mOpen)
+    {
+        nVoices = Mix_AllocateChannels(nVoices);
+        mBufferTime = (Uint64)AUDIO_BUFFER*SDL_GetPerformanceFrequency()/frequency;
+    }
+
+    Voice idle = { 0, 0, 0 };
+    mVoices.assign(nVoices, idle);
+}
+
+/**
+ * @brief Destructor - stops every sound and the music
+ * Must run before the audio device is closed.
+ */
+Audio::~Audio()
+{
+    if (mOpen)
+    {
+        Mix_HaltChannel(-1);
+        Mix_HaltMusic();
+    }
+}
+
+/**
+ * @brief Check whether there is an audio device
+ */
+bool Audio::isOpen() const
+{
+    return mOpen;
+}
+
+/**
+ * @brief Load a sound into the bank
+ * Loading the same file again returns the same sound. A sound which
+ * could not be loaded still gets an id, playing it does nothing.
+ * @param priority Sounds of higher priority steal voices from lower ones
+ * @param maxInstances Maximum number of voices playing it at once
+ */
+SoundId Audio::load(const std::string& filename, int priority, unsigned int maxInstances)
+{
+    std::map<std::string, SoundId>::const_iterator it = mIds.find(filename);
+    if (it != mIds.end())
+    {
+        return it->second;
+    }
+
+    Sound sound;
+    sound.priority     = priority;
+    sound.maxInstances = std::max(maxInstances, 1u);
+    sound.lastStart    = 0;
+
+    if (mOpen)
+    {
+        Mix_Chunk* chunk = Mix_LoadWAV( filename.c_str() );
+        if( chunk == NULL )
+        {
+            printf( "Failed to load sound %s! SDL_mixer Error: %s\n", filename.c_str(), Mix_GetError() );
+        }
+        else
+        {
+            sound.chunk = std::shared_ptr<Mix_Chunk>(chunk, Mix_FreeChunk);
+        }
+    }
+
+    mSounds.push_back(sound);
+    mIds[filename] = mSounds.size() - 1;
+
+    return mSounds.size() - 1;
+}
+
+/**
+ * @brief Play a sound
+ * @return Voice it plays on, -1 if it was dropped (or there is no sound)
+ */
+int Audio::play(SoundId sound)
+{
+    if (sound >= mSounds.size())
+    {
+        throw std::out_of_range(" Unknown sound!");
+    }
+
+    Sound& entry = mSounds[sound];
+    if (entry.chunk == NULL)
+    {
+        return -1;
+    }
+
+    Uint64 now = SDL_GetPerformanceCounter();
+    if ((entry.lastStart != 0) && (now - entry.lastStart < mBufferTime))
+    {
+        mDropped++;
+        return -1;
+    }
+
+    int voice = findVoice(sound);
+    if ((voice < 0) || (Mix_PlayChannel(voice, entry.chunk.get(), 0) < 0))
+    {
+        mDropped++;
+        return -1;
+    }
+
+    mVoices[voice].sound    = sound;
+    mVoices[voice].priority = entry.priority;
+    mVoices[voice].start    = now;
+    entry.lastStart         = now;
+    mPlayed++;
+
+    return voice;
+}
+
+/**
+ * @brief Play music, looping
+ * The music is kept alive while it plays.
+ */
+void Audio::playMusic(const std::shared_ptr<Mix_Music>& music)
+{
+    if (!mOpen || (music == NULL))
+    {
+        return;
+    }
+
+    if( Mix_PlayMusic( music.get(), -1 ) < 0 )
+    {
+        printf( "Failed to play music! SDL_mixer Error: %s\n", Mix_GetError() );
+        return;
+    }
+    mMusic = music;
+}
+
+/**
+ * @brief Get number of voices
+ */
+unsigned int Audio::getNVoices() const
+{
+    return mVoices.size();
+}
+
+/**
+ * @brief Get number of sounds started
+ */
+unsigned long Audio::getPlayed() const
+{
+    return mPlayed;
+}
+
+/**
+ * @brief Get number of voices stolen from other sounds
+ * Includes a sound taking over its own oldest voice.
+ */
+unsigned long Audio::getStolen() const
+{
+    return mStolen;
+}
+
+/**
+ * @brief Get number of sounds dropped
+ */
+unsigned long Audio::getDropped() const
+{
+    return mDropped;
+}
+
+/**
+ * @brief Pick a voice for a sound
+ * A free voice if the sound may have another instance, else a voice to
+ * steal: its own oldest if it has too many instances, otherwise the
+ * lowest priority, oldest one not above its priority.
+ */
+int Audio::findVoice(SoundId sound)
+{
+    int priority = mSounds[sound].priority;
+
+    int idle = -1, oldestOwn = -1, victim = -1;
+    unsigned int instances = 0;
+    for (unsigned int v = 0; v < mVoices.size(); v++)
+    {
+        if (!Mix_Playing(v))
+        {
+            idle = (idle < 0) ? v : idle;
+            continue;
+        }
+
+        const Voice& voice = mVoices[v];
+        if (voice.sound == sound)
+        {
+            instances++;
+            if ((oldestOwn < 0) || (voice.start < mVoices[oldestOwn].start))
+            {
+                oldestOwn = v;
+            }
+        }
+        if ((voice.priority <= priority) &&
+            ((victim < 0) || (voice.priority < mVoices[victim].priority) ||
+             ((voice.priority == mVoices[victim].priority) && (voice.start < mVoices[victim].start))))
+        {
+            victim = v;
+        }
+    }
+
+    if (instances >= mSounds[sound].maxInstances)
+    {
+        mStolen++;
+        return oldestOwn;
+    }
+    if (idle >= 0)
+    {
+        return idle;
+    }
+    if (victim >= 0)
+    {
+        mStolen++;
+    }
+
+    return victim;
+}
@@ -0,0 +1,267 @@
+/**
+ * @file
+ *
+ * @brief Headless benchmark of the simulation pipeline
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory>
+#include <random>
+#include <string>
+
+#include <SDL.h>
+
+#include "sdlInit.h"
+#include "simulation.h"
+#include "textureAtlas.h"
+#include "spriteBatch.h"
+#include "maskKernel.h"
+#include "hitchDetector.h"
+
+// Phases of a tick, in order
+enum Phase
+{
+    PHASE_SPAWN,
+    PHASE_CULL,
+    PHASE_ANIMATE,
+    PHASE_COLLIDE,
+    PHASE_DRAW,
+    N_PHASES
+};
+
+static const char* phaseNames[N_PHASES] = { "spawn", "cull", "animate", "collide", "draw" };
+
+/**
+ * @brief Benchmark main function
+ *
+ * Runs the spawn/cull/animate/collide pipeline of the game headless, as
+ * fast as possible, keeping the number of enemies constant.
+ *
+ * Options:
+ *   --ticks N    number of measured ticks (default 10000)
+ *   --enemies N  number of enemies kept alive (default 1000)
+ *   --seed N     seed for the random number generator
+ *   --draw       also draw every tick (software renderer)
+ *   --threads N  run animate and collide as jobs on N worker threads
+ *                (their time is then reported under collide)
+ *   --kernel K   narrow phase kernel: scalar, sse2 or avx2 (default: best)
+ *   --cache      reuse narrow phase results of earlier ticks
+ */
+int main(int argvc, char* argv[])
+{
+    unsigned long ticks   = 10000;
+    unsigned int enemies  = 1000;
+    unsigned int seed     = std::default_random_engine::default_seed;
+    bool draw             = false;
+    int threads           = -1;
+    bool cache            = false;
+    for (int i = 1; i < argvc; i++)
+    {
+        std::string arg = argv[i];
+        if ((arg == "--ticks") && (i + 1 < argvc))
+        {
+            ticks = strtoul(argv[++i], NULL, 10);
+        }
+        else if ((arg == "--enemies") && (i + 1 < argvc))
+        {
+            enemies = strtoul(argv[++i], NULL, 10);
+        }
+        else if ((arg == "--seed") && (i + 1 < argvc))
+        {
+            seed = strtoul(argv[++i], NULL, 10);
+        }
+        else if ((arg == "--threads") && (i + 1 < argvc))
+        {
+            threads = atoi(argv[++i]);
+        }
+        else if ((arg == "--kernel") && (i + 1 < argvc))
+        {
+            if (!selectMaskKernel(argv[++i]))
+            {
+                printf( "Kernel %s is not supported, using %s\n", argv[i], getMaskKernelName() );
+            }
+        }
+        else if (arg == "--cache")
+        {
+            cache = true;
+        }
+        else if (arg == "--draw")
+        {
+            draw = true;
+        }
+    }
+
+    if( !sdlInitHeadless() )
+    {
+        printf( "Failed to initialize!\n" );
+        return -1;
+    }
+
+    {
+        Simulation simulation(seed);
+        simulation.setCollisionCache(cache);
+
+        std::unique_ptr<JobSystem> jobs;
+        if (threads >= 0)
+        {
+            jobs.reset(new JobSystem(threads));
+            simulation.setJobSystem(jobs.get());
+        }
+
+        TextureAtlas atlas;
+        simulation.addSheets(atlas);
+        atlas.build();
+        SpriteBatch batch(&atlas);
+
+        Uint64 frequency = SDL_GetPerformanceFrequency();
+        Uint64 phaseTime[N_PHASES] = { 0 };
+        Uint64 total = 0;
+        unsigned long collisions = 0;
+        unsigned long allocationsStart = 0;
+        unsigned long growthsStart     = 0;
+        unsigned long arenaAllocations = 0;
+        unsigned long arenaOverflows   = 0;
+        unsigned long spritesDrawn     = 0;
+        unsigned long spritesCulled    = 0;
+
+        // A few unmeasured ticks first, so buffers reach their final size
+        unsigned long warmup = 100;
+        for (unsigned long t = 0; t < warmup + ticks; t++)
+        {
+            if (t == warmup)
+            {
+                allocationsStart = getAllocations();
+                growthsStart     = simulation.getEnemies().getGrowths();
+                arenaAllocations = 0;
+                arenaOverflows   = 0;
+                spritesDrawn     = 0;
+                spritesCulled    = 0;
+                total = 0;
+                for (int p = 0; p < N_PHASES; p++)
+                {
+                    phaseTime[p] = 0;
+                }
+            }
+
+            Uint64 start = SDL_GetPerformanceCounter();
+            Uint64 now;
+
+            simulation.savePos();
+            simulation.input(0);
+            simulation.spawn();
+            now = SDL_GetPerformanceCounter();
+            phaseTime[PHASE_SPAWN] += now - start;
+            start = now;
+
+            simulation.cull();
+            if (simulation.getEnemies().size() < enemies)
+            {
+                simulation.spawn(enemies - simulation.getEnemies().size());
+            }
+            now = SDL_GetPerformanceCounter();
+            phaseTime[PHASE_CULL] += now - start;
+            start = now;
+
+            if (jobs)
+            {
+                collisions += simulation.animateAndCollide();
+                now = SDL_GetPerformanceCounter();
+                phaseTime[PHASE_COLLIDE] += now - start;
+                start = now;
+            }
+            else
+            {
+                simulation.animate();
+                now = SDL_GetPerformanceCounter();
+                phaseTime[PHASE_ANIMATE] += now - start;
+                start = now;
+
+                collisions += simulation.collide();
+                now = SDL_GetPerformanceCounter();
+                phaseTime[PHASE_COLLIDE] += now - start;
+                start = now;
+            }
+
+            // Scratch memory use of this tick, before the next one releases it
+            arenaAllocations += simulation.getArena().getAllocations();
+            arenaOverflows   += simulation.getArena().getOverflows();
+
+            if (draw)
+            {
+                SDL_SetRenderDrawColor( renderer, 0, 0, 0, 255 );
+                SDL_RenderClear( renderer );
+                simulation.draw(batch, 1.0);
+                batch.flush();
+                spritesDrawn  += batch.getNSprites();
+                spritesCulled += batch.getNCulled();
+                SDL_RenderPresent( renderer );
+                now = SDL_GetPerformanceCounter();
+                phaseTime[PHASE_DRAW] += now - start;
+            }
+        }
+
+        for (int p = 0; p < N_PHASES; p++)
+        {
+            total += phaseTime[p];
+        }
+        double seconds = (double)total/frequency;
+
+        printf( "ticks:        %lu\n", ticks );
+        printf( "enemies:      %u\n", enemies );
+        printf( "seed:         %u\n", seed );
+        printf( "threads:      %s\n", jobs ? std::to_string(threads).c_str() : "serial" );
+        printf( "kernel:       %s\n", getMaskKernelName() );
+        printf( "collisions:   %lu\n", collisions );
+        printf( "ticks/sec:    %.1f\n", (seconds > 0) ? ticks/seconds : 0.0 );
+        printf( "allocs/tick:  %.3f\n", ticks ? (double)(getAllocations() - allocationsStart)/ticks : 0.0 );
+        printf( "pool:         %u high water, %u capacity, %lu growths\n",
+                simulation.getEnemies().getHighWater(), simulation.getEnemies().getCapacity(),
+                simulation.getEnemies().getGrowths() - growthsStart );
+        printf( "arena:        %lu bytes high water, %.3f allocs/tick, %lu overflows\n",
+                (unsigned long) simulation.getArena().getHighWater(),
+                ticks ? (double)arenaAllocations/ticks : 0.0, arenaOverflows );
+        if (draw)
+        {
+            printf( "sprites:      %.1f drawn/tick, %.1f culled/tick\n",
+                    ticks ? (double)spritesDrawn/ticks : 0.0, ticks ? (double)spritesCulled/ticks : 0.0 );
+        }
+        if (cache)
+        {
+            const CollisionCache& pairs = simulation.getCollisionCache();
+            printf( "pair cache:   %lu tested, %lu reused, %lu skipped\n",
+                    pairs.getTested(), pairs.getReused(), pairs.getSkipped() );
+        }
+        for (int p = 0; p < N_PHASES; p++)
+        {
+            double ms = 1000.0*phaseTime[p]/frequency;
+            printf( "%-12s  %10.3f ms total  %8.4f ms/tick  %5.1f %%\n", phaseNames[p], ms,
+                    ticks ? ms/ticks : 0.0, total ? 100.0*phaseTime[p]/total : 0.0 );
+        }
+    }
+
+    sdlClose();
+
+    return 0;
+}
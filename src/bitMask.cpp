@@ -0,0 +1,197 @@
+/**
+ * @file
+ *
+ * @brief Defines packed 1 bit per pixel collision masks
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bitMask.h"
+
+/**
+ * @class Collision mask of a sprite sheet, one bit per pixel and one mask
+ * per animation frame. Bit i of word w of a row is pixel x = 64*w + i.
+ * Every row ends with a zero padding word, so 64 bits can be read starting
+ * at any pixel of the row without bounds checks.
+ *
+ * A pixel is solid unless it has the chroma key color (COLOR_KEY) or is
+ * fully transparent.
+ */
+BitMask::BitMask(SDL_Surface* surface, int width, int height)
+{
+    mWidth       = width;
+    mHeight      = height;
+    mNFrames     = 0;
+    mWordsPerRow = (width + 63)/64 + 1;
+
+    if ((surface == NULL) || (width <= 0) || (height <= 0))
+    {
+        return;
+    }
+
+    mNFrames = surface->w/width;
+    if (0 == mNFrames)
+    {
+        mNFrames = 1;
+    }
+    mBits.assign(mNFrames*height*mWordsPerRow, 0);
+
+    // Work on a known pixel format, whatever the image was
+    SDL_Surface* pixels = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (pixels == NULL)
+    {
+        printf( "Unable to build collision mask! SDL Error: %s\n", SDL_GetError() );
+        return;
+    }
+
+    if (SDL_MUSTLOCK(pixels))
+    {
+        SDL_LockSurface(pixels);
+    }
+
+    for (unsigned int frame = 0; frame < mNFrames; frame++)
+    {
+        for (int y = 0; (y < height) && (y < pixels->h); y++)
+        {
+            const Uint32* src = (const Uint32*)((const Uint8*)pixels->pixels + y*pixels->pitch);
+            Uint64* row = &mBits[(frame*height + y)*mWordsPerRow];
+
+            for (int x = 0; x < width; x++)
+            {
+                int srcX = frame*width + x;
+                if (srcX >= pixels->w)
+                {
+                    break;
+                }
+
+                Uint8 r, g, b, a;
+                SDL_GetRGBA(src[srcX], pixels->format, &r, &g, &b, &a);
+
+                bool keyed = (r == COLOR_KEY[0]) && (g == COLOR_KEY[1]) && (b == COLOR_KEY[2]);
+                if ((a != 0) && !keyed)
+                {
+                    row[x >> 6] |= (Uint64)1 << (x & 63);
+                }
+            }
+        }
+    }
+
+    if (SDL_MUSTLOCK(pixels))
+    {
+        SDL_UnlockSurface(pixels);
+    }
+    SDL_FreeSurface(pixels);
+}
+
+/**
+ * @brief Constructor - copies prebuilt masks
+ * bits holds nFrames*height rows laid out as built by the other
+ * constructor, each word little-endian, e.g. as baked by engineZBake.
+ */
+BitMask::BitMask(int width, int height, unsigned int nFrames, const Uint64* bits)
+{
+    mWidth       = width;
+    mHeight      = height;
+    mNFrames     = nFrames;
+    mWordsPerRow = (width + 63)/64 + 1;
+
+    mBits.resize(mNFrames*height*mWordsPerRow);
+    for (std::size_t i = 0; i < mBits.size(); i++)
+    {
+        mBits[i] = SDL_SwapLE64(bits[i]);
+    }
+}
+
+// Destructor
+BitMask::~BitMask()
+{
+
+}
+
+/**
+ * @brief Get width of a frame
+ */
+int BitMask::getWidth() const
+{
+    return mWidth;
+}
+
+/**
+ * @brief Get height of a frame
+ */
+int BitMask::getHeight() const
+{
+    return mHeight;
+}
+
+/**
+ * @brief Get number of frames
+ */
+unsigned int BitMask::getNFrames() const
+{
+    return mNFrames;
+}
+
+/**
+ * @brief Get number of 64 bit words per row, including the padding word
+ */
+unsigned int BitMask::getWordsPerRow() const
+{
+    return mWordsPerRow;
+}
+
+/**
+ * @brief Get row y of a given frame
+ * Frame numbers wrap around, like Sprite::updateFrame. Returns NULL if the
+ * mask is empty.
+ */
+const Uint64* BitMask::getRow(unsigned int frame, int y) const
+{
+    if (0 == mNFrames)
+    {
+        return NULL;
+    }
+
+    return &mBits[((frame % mNFrames)*mHeight + y)*mWordsPerRow];
+}
+
+/**
+ * @brief Check whether pixel (x,y) of a given frame is solid
+ * Coordinates are relative to the top-left corner of the frame.
+ */
+bool BitMask::isSolid(unsigned int frame, int x, int y) const
+{
+    if ((x < 0) || (y < 0) || (x >= mWidth) || (y >= mHeight) || (0 == mNFrames))
+    {
+        return false;
+    }
+
+    return (getRow(frame, y)[x >> 6] >> (x & 63)) & 1;
+}
+
+/**
+ * @brief Get number of bytes used by the mask
+ */
+std::size_t BitMask::getBytes() const
+{
+    return mBits.size()*sizeof(Uint64);
+}
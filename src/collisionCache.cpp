@@ -0,0 +1,259 @@
+/**
+ * @file
+ *
+ * @brief Defines a cache for narrow phase results
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "collisionCache.h"
+#include "spriteFunctions.h"
+
+/**
+ * @brief Upper bound for getTimeToContact
+ */
+#define MAX_TIME_TO_CONTACT (1u << 20)
+
+/**
+ * @class Frame-to-frame cache of narrow phase results. In a side scroller
+ * most pairs look the same from one tick to the next, so a pair is only
+ * tested again if one of its animation frames or their relative position
+ * (now or in the previous tick, since the test is swept) changed.
+ *
+ * Pairs which are apart are not tested again until they could possibly
+ * touch: with the gap between their bounding boxes along an axis and how
+ * fast they can close it, the number of ticks to contact is known (a
+ * separating axis test with speed bounds).
+ *
+ * The table is open addressing with linear probing. Entries not used for
+ * a tick are free again, so there is no explicit removal and a removed
+ * entity's entries just age out. If a lookup stops at a free entry before
+ * reaching an older copy of the pair, the pair is simply tested again.
+ *
+ * @note Not thread safe.
+ */
+CollisionCache::CollisionCache()
+    :mEntries(COLLISION_CACHE_SIZE),
+     mTick(1),
+     mTouched(0),
+     mTouchedPrev(0),
+     mReused(0),
+     mSkipped(0),
+     mTested(0)
+{
+    clear();
+}
+
+// Destructor
+CollisionCache::~CollisionCache()
+{
+
+}
+
+/**
+ * @brief Start a new tick
+ */
+void CollisionCache::beginTick()
+{
+    mTick++;
+    mTouchedPrev = mTouched;
+    mTouched     = 0;
+}
+
+/**
+ * @brief Check a pair for collision
+ * Exact as long as neither body moves faster than its maxSpeed.
+ */
+bool CollisionCache::test(const CollisionBody& a, const CollisionBody& b)
+{
+    // Keep the table at most half full, so that probing stays short and
+    // always ends (this drops all results, which only costs a few tests)
+    if (2*(mTouchedPrev + mTouched + 1) > mEntries.size())
+    {
+        mEntries.resize(2*mEntries.size());
+        clear();
+    }
+
+    Entry& entry = find(a.handle, b.handle);
+
+    int offsetX     = b.x - a.x;
+    int offsetY     = b.y - a.y;
+    int prevOffsetX = b.prevX - a.prevX;
+    int prevOffsetY = b.prevY - a.prevY;
+
+    if (isUsed(entry))
+    {
+        if (entry.tick != mTick)
+        {
+            entry.tick = mTick;
+            mTouched++;
+        }
+
+        // Cannot have moved into contact yet
+        if (mTick < entry.skipUntil)
+        {
+            mSkipped++;
+            return false;
+        }
+
+        // Nothing relevant changed
+        if ((entry.frameA == a.frame) && (entry.frameB == b.frame) &&
+            (entry.offsetX == offsetX) && (entry.offsetY == offsetY) &&
+            (entry.prevOffsetX == prevOffsetX) && (entry.prevOffsetY == prevOffsetY))
+        {
+            mReused++;
+            return entry.result;
+        }
+    }
+    else
+    {
+        entry.handleA = a.handle;
+        entry.handleB = b.handle;
+        entry.tick    = mTick;
+        mTouched++;
+    }
+
+    mTested++;
+
+    // Apart now does not mean they did not pass through each other during
+    // this tick, so the swept test always runs. The time to contact only
+    // holds for the coming ticks.
+    entry.skipUntil   = mTick + getTimeToContact(a, b);
+    entry.offsetX     = offsetX;
+    entry.offsetY     = offsetY;
+    entry.prevOffsetX = prevOffsetX;
+    entry.prevOffsetY = prevOffsetY;
+    entry.frameA      = a.frame;
+    entry.frameB      = b.frame;
+    entry.result      = sweptMaskCollision(a.mask, a.frame, a.prevX, a.prevY, a.x, a.y,
+                                           b.mask, b.frame, b.prevX, b.prevY, b.x, b.y);
+
+    return entry.result;
+}
+
+/**
+ * @brief Forget everything
+ */
+void CollisionCache::clear()
+{
+    for (unsigned int i = 0; i < mEntries.size(); i++)
+    {
+        mEntries[i].tick = 0;
+    }
+
+    // Entries of tick 0 are free from tick 2 on
+    mTick        = 2;
+    mTouched     = 0;
+    mTouchedPrev = 0;
+}
+
+/**
+ * @brief Get number of tests answered from the cache
+ */
+unsigned long CollisionCache::getReused() const
+{
+    return mReused;
+}
+
+/**
+ * @brief Get number of tests skipped since contact was impossible
+ */
+unsigned long CollisionCache::getSkipped() const
+{
+    return mSkipped;
+}
+
+/**
+ * @brief Get number of tests which ran the narrow phase
+ */
+unsigned long CollisionCache::getTested() const
+{
+    return mTested;
+}
+
+/**
+ * @brief Find entry of a pair
+ * @return The pair's entry, or the free entry it should go to
+ */
+CollisionCache::Entry& CollisionCache::find(EntityHandle a, EntityHandle b)
+{
+    Uint64 hash = (a*0x9E3779B97F4A7C15ull) ^ (b + 0x632BE59BD9B4E019ull + (a << 6));
+    hash ^= hash >> 29;
+
+    unsigned int sizeMask = mEntries.size() - 1;
+    unsigned int i        = hash & sizeMask;
+    while (true)
+    {
+        Entry& entry = mEntries[i];
+        if (!isUsed(entry) || ((entry.handleA == a) && (entry.handleB == b)))
+        {
+            return entry;
+        }
+        i = (i + 1) & sizeMask;
+    }
+}
+
+/**
+ * @brief Check whether an entry was used in this or the previous tick
+ */
+bool CollisionCache::isUsed(const Entry& entry) const
+{
+    return entry.tick + 1 >= mTick;
+}
+
+/**
+ * @brief Get ticks until two bodies could possibly touch
+ * Along each axis the bounding boxes need gap/speed ticks to close a gap,
+ * where speed is the sum of both speed bounds. They can only touch once
+ * both axes overlap, so the larger of the two is a safe lower bound.
+ * @return 0 if the bounding boxes overlap now
+ */
+unsigned int getTimeToContact(const CollisionBody& a, const CollisionBody& b)
+{
+    if ((a.mask == NULL) || (b.mask == NULL))
+    {
+        return MAX_TIME_TO_CONTACT;
+    }
+
+    int gapX = std::max(b.x - (a.x + a.mask->getWidth()),  a.x - (b.x + b.mask->getWidth()));
+    int gapY = std::max(b.y - (a.y + a.mask->getHeight()), a.y - (b.y + b.mask->getHeight()));
+
+    int speedX = std::abs(a.maxSpeedX) + std::abs(b.maxSpeedX);
+    int speedY = std::abs(a.maxSpeedY) + std::abs(b.maxSpeedY);
+
+    unsigned int time = 0;
+
+    // Overlap along an axis needs a negative gap
+    if (gapX >= 0)
+    {
+        time = (speedX > 0) ? std::min((unsigned int)(gapX/speedX) + 1, MAX_TIME_TO_CONTACT)
+                            : MAX_TIME_TO_CONTACT;
+    }
+    if (gapY >= 0)
+    {
+        unsigned int timeY = (speedY > 0) ? std::min((unsigned int)(gapY/speedY) + 1, MAX_TIME_TO_CONTACT)
+                                          : MAX_TIME_TO_CONTACT;
+        time = std::max(time, timeY);
+    }
+
+    return time;
+}
@@ -28,7 +28,7 @@
 #include "enemy.h"
 
 // Constructor
-Enemy::Enemy(int width, int height, int nSprites, std::string filename)
+Enemy::Enemy(int width, int height, int nSprites, const std::string& filename)
      :Sprite(width, height, nSprites, filename)
 {
     //Default values
@@ -36,12 +36,24 @@ Enemy::Enemy(int width, int height, int nSprites, std::string filename)
     setVX(-1);
 }
 
+//Copy constructor
+Enemy::Enemy(const Enemy& other) = default;
+
+//Move constructor
+Enemy::Enemy(Enemy&& other) noexcept = default;
+
 //Destructor
 Enemy::~Enemy()
 {
 
 }
 
+//Copy assignment
+Enemy& Enemy::operator=(const Enemy& other) = default;
+
+//Move assignment
+Enemy& Enemy::operator=(Enemy&& other) noexcept = default;
+
 /**
  * @brief Get HP
  */
@@ -0,0 +1,608 @@
+/**
+ * @file
+ *
+ * @brief Defines a packed store for large numbers of sprite entities
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "entityStore.h"
+#include "assetCache.h"
+
+/**
+ * @class Store for entities which only differ in position, speed and
+ * animation frame (e.g. enemies). Everything a sprite type has in common
+ * (size, sprite sheet, mask) is stored once per type and every entity
+ * field lives in its own contiguous array, so per tick updates are linear
+ * passes over plain ints.
+ *
+ * Entities are removed by moving the last entity into the freed index, so
+ * indices are not stable. Anything which needs to refer to an entity across
+ * removals should keep an EntityHandle instead.
+ */
+EntityStore::EntityStore()
+    :mCapacity(0),
+     mHighWater(0),
+     mGrowths(0)
+{
+
+}
+
+// Destructor
+EntityStore::~EntityStore()
+{
+
+}
+
+/**
+ * @brief Register a sprite type
+ * The sprite sheet and mask are taken from the asset cache, so registering
+ * the same file twice does not load it twice.
+ * @return Type id to be used with spawn
+ */
+unsigned int EntityStore::addType(int width, int height, unsigned int nSprites,
+                                  const std::string& filename)
+{
+    return addType(width, height, filename, filename,
+                   std::vector<unsigned int>(nSprites, 1));
+}
+
+/**
+ * @brief Register a sprite type with its own mask image and frame durations
+ * durations holds the number of ticks each animation frame is shown, its
+ * size is the number of frames.
+ * @return Type id to be used with spawn
+ */
+unsigned int EntityStore::addType(int width, int height, const std::string& sheet,
+                                  const std::string& mask,
+                                  const std::vector<unsigned int>& durations)
+{
+    // Throw exception whenever nSprites = 0, frames could not be updated
+    if (durations.empty())
+    {
+        throw std::length_error(" Number of sprites in sheet is 0!");
+    }
+
+    mTypeWidth.push_back(width);
+    mTypeHeight.push_back(height);
+    mTypeNSprites.push_back(durations.size());
+    mTypeSheet.push_back(assetCache.getTexture(sheet));
+    mTypeMask.push_back(assetCache.getMask(mask, width, height));
+    mTypeDurations.push_back(mDurations.size());
+    for (unsigned int k = 0; k < durations.size(); k++)
+    {
+        mDurations.push_back(std::max(1u, durations[k]));
+    }
+
+    return mTypeWidth.size() - 1;
+}
+
+/**
+ * @brief Register a sprite type from a sprite manifest
+ * @return Type id to be used with spawn
+ */
+unsigned int EntityStore::addType(const SpriteManifest& manifest, unsigned int sprite)
+{
+    SDL_Rect frame = manifest.getFrame(sprite, 0);
+
+    return addType(frame.w, frame.h, manifest.getSheet(sprite), manifest.getMask(sprite),
+                   manifest.getDurations(sprite));
+}
+
+/**
+ * @brief Create entity
+ * The new entity is appended, i.e. its index is size() - 1.
+ * @return Handle to the new entity, INVALID_ENTITY if the store is full
+ */
+EntityHandle EntityStore::spawn(unsigned int type, int x, int y, int vX, int vY)
+{
+    if (type >= mTypeWidth.size())
+    {
+        throw std::out_of_range(" Unknown sprite type!");
+    }
+
+    if ((mCapacity > 0) && (mPosX.size() >= mCapacity))
+    {
+        return INVALID_ENTITY;
+    }
+
+    // Arrays are about to reallocate
+    if (mPosX.size() == mPosX.capacity())
+    {
+        mGrowths++;
+    }
+
+    // Reuse a free slot if there is one
+    unsigned int slot;
+    if (!mFreeSlots.empty())
+    {
+        slot = mFreeSlots.back();
+        mFreeSlots.pop_back();
+    }
+    else
+    {
+        slot = mSlotIndex.size();
+        mSlotIndex.push_back(0);
+        mSlotGeneration.push_back(1);
+    }
+    mSlotIndex[slot] = mPosX.size();
+
+    mPosX.push_back(x);
+    mPosY.push_back(y);
+    mPrevPosX.push_back(x);
+    mPrevPosY.push_back(y);
+    mVX.push_back(vX);
+    mVY.push_back(vY);
+    mFrame.push_back(0);
+    mFrameTicks.push_back(mDurations[mTypeDurations[type]]);
+    mType.push_back(type);
+    mSlot.push_back(slot);
+    mDead.push_back(0);
+
+    if (mPosX.size() > mHighWater)
+    {
+        mHighWater = mPosX.size();
+    }
+
+    return ((EntityHandle)mSlotGeneration[slot] << 32) | slot;
+}
+
+/**
+ * @brief Remove entity at a given index
+ * O(1): the last entity is moved into index i, so it changes index.
+ */
+void EntityStore::erase(unsigned int i)
+{
+    swapAndPop(i);
+}
+
+/**
+ * @brief Remove entity referred to by a handle
+ * Does nothing if the entity was already removed.
+ */
+void EntityStore::remove(EntityHandle handle)
+{
+    if (isAlive(handle))
+    {
+        swapAndPop(getIndex(handle));
+    }
+}
+
+/**
+ * @brief Mark entity for removal
+ * The entity stays in the store (and keeps its index) until compact() is
+ * called, so it is safe to call this while iterating over entities.
+ */
+void EntityStore::kill(unsigned int i)
+{
+    mDead[i] = 1;
+}
+
+/**
+ * @brief Remove all entities marked by kill()
+ * Single pass; every removal moves the last entity into the hole.
+ * @return Number of removed entities
+ */
+unsigned int EntityStore::compact()
+{
+    unsigned int removed = 0;
+    unsigned int i = 0;
+
+    while (i < mPosX.size())
+    {
+        if (mDead[i])
+        {
+            // The entity moved into i has not been checked yet, so i
+            // is not advanced
+            swapAndPop(i);
+            removed++;
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    return removed;
+}
+
+/**
+ * @brief Check whether a handle still refers to an entity
+ */
+bool EntityStore::isAlive(EntityHandle handle) const
+{
+    unsigned int slot       = (unsigned int)(handle & 0xFFFFFFFF);
+    unsigned int generation = (unsigned int)(handle >> 32);
+
+    return (slot < mSlotGeneration.size()) && (mSlotGeneration[slot] == generation);
+}
+
+/**
+ * @brief Get current index of the entity referred to by a handle
+ * Throws std::out_of_range if the entity was removed.
+ */
+unsigned int EntityStore::getIndex(EntityHandle handle) const
+{
+    if (!isAlive(handle))
+    {
+        throw std::out_of_range(" Entity handle refers to a removed entity!");
+    }
+
+    return mSlotIndex[(unsigned int)(handle & 0xFFFFFFFF)];
+}
+
+/**
+ * @brief Get handle of the entity at a given index
+ */
+EntityHandle EntityStore::getHandle(unsigned int i) const
+{
+    unsigned int slot = mSlot[i];
+
+    return ((EntityHandle)mSlotGeneration[slot] << 32) | slot;
+}
+
+/**
+ * @brief Remove all entities
+ * Sprite types are kept.
+ */
+void EntityStore::clear()
+{
+    mPosX.clear();
+    mPosY.clear();
+    mPrevPosX.clear();
+    mPrevPosY.clear();
+    mVX.clear();
+    mVY.clear();
+    mFrame.clear();
+    mFrameTicks.clear();
+    mType.clear();
+    mDead.clear();
+
+    // Invalidate every outstanding handle
+    for (unsigned int i = 0; i < mSlot.size(); i++)
+    {
+        unsigned int slot = mSlot[i];
+        mSlotGeneration[slot]++;
+        if (0 == mSlotGeneration[slot])
+        {
+            mSlotGeneration[slot] = 1;
+        }
+        mFreeSlots.push_back(slot);
+    }
+    mSlot.clear();
+}
+
+/**
+ * @brief Get number of entities
+ */
+unsigned int EntityStore::size() const
+{
+    return mPosX.size();
+}
+
+/**
+ * @brief Reserve space for a number of entities
+ */
+void EntityStore::reserve(unsigned int n)
+{
+    mPosX.reserve(n);
+    mPosY.reserve(n);
+    mPrevPosX.reserve(n);
+    mPrevPosY.reserve(n);
+    mVX.reserve(n);
+    mVY.reserve(n);
+    mFrame.reserve(n);
+    mFrameTicks.reserve(n);
+    mType.reserve(n);
+    mSlot.reserve(n);
+    mDead.reserve(n);
+}
+
+/**
+ * @brief Limit the number of entities
+ * Space for all of them is reserved up front (handle slots included), so
+ * spawning and removing never touches the heap afterwards. Spawning into
+ * a full store fails instead of growing it. 0 removes the limit.
+ */
+void EntityStore::setCapacity(unsigned int n)
+{
+    mCapacity = n;
+
+    reserve(n);
+    mSlotIndex.reserve(n);
+    mSlotGeneration.reserve(n);
+    mFreeSlots.reserve(n);
+}
+
+/**
+ * @brief Get maximum number of entities, 0 if unlimited
+ */
+unsigned int EntityStore::getCapacity() const
+{
+    return mCapacity;
+}
+
+/**
+ * @brief Get most entities alive at once
+ */
+unsigned int EntityStore::getHighWater() const
+{
+    return mHighWater;
+}
+
+/**
+ * @brief Get number of times the entity arrays had to grow
+ * Stays constant in steady state, or at all with setCapacity.
+ */
+unsigned long EntityStore::getGrowths() const
+{
+    return mGrowths;
+}
+
+/**
+ * @brief Get X position of entity
+ */
+int EntityStore::getPosX(unsigned int i) const
+{
+    return mPosX[i];
+}
+
+/**
+ * @brief Get Y position of entity
+ */
+int EntityStore::getPosY(unsigned int i) const
+{
+    return mPosY[i];
+}
+
+/**
+ * @brief Get X position of entity in the previous tick
+ */
+int EntityStore::getPrevPosX(unsigned int i) const
+{
+    return mPrevPosX[i];
+}
+
+/**
+ * @brief Get Y position of entity in the previous tick
+ */
+int EntityStore::getPrevPosY(unsigned int i) const
+{
+    return mPrevPosY[i];
+}
+
+/**
+ * @brief Get x speed of entity
+ */
+int EntityStore::getVX(unsigned int i) const
+{
+    return mVX[i];
+}
+
+/**
+ * @brief Get y speed of entity
+ */
+int EntityStore::getVY(unsigned int i) const
+{
+    return mVY[i];
+}
+
+/**
+ * @brief Get animation frame of entity
+ */
+unsigned int EntityStore::getFrame(unsigned int i) const
+{
+    return mFrame[i];
+}
+
+/**
+ * @brief Get ticks left until the next animation frame of entity
+ */
+unsigned int EntityStore::getFrameTicks(unsigned int i) const
+{
+    return mFrameTicks[i];
+}
+
+/**
+ * @brief Get sprite type of entity
+ */
+unsigned int EntityStore::getType(unsigned int i) const
+{
+    return mType[i];
+}
+
+/**
+ * @brief Get width of entity
+ */
+int EntityStore::getWidth(unsigned int i) const
+{
+    return mTypeWidth[mType[i]];
+}
+
+/**
+ * @brief Get height of entity
+ */
+int EntityStore::getHeight(unsigned int i) const
+{
+    return mTypeHeight[mType[i]];
+}
+
+/**
+ * @brief Get mask of entity
+ */
+const BitMask* EntityStore::getMask(unsigned int i) const
+{
+    return mTypeMask[mType[i]].get();
+}
+
+/**
+ * @brief Remember current positions as the previous tick's positions
+ */
+void EntityStore::savePos()
+{
+    mPrevPosX = mPosX;
+    mPrevPosY = mPosY;
+}
+
+/**
+ * @brief Move every entity and advance its animation by one tick
+ * x <- x + vx
+ * y <- y + vy
+ */
+void EntityStore::update()
+{
+    update(0, mPosX.size());
+}
+
+/**
+ * @brief Move and animate entities [begin, end)
+ * Ranges do not share any data, so disjoint ranges can be updated on
+ * different threads.
+ */
+void EntityStore::update(unsigned int begin, unsigned int end)
+{
+    unsigned int n = std::min(end, (unsigned int)mPosX.size());
+
+    // Plain loops over contiguous arrays, these are easy to vectorize
+    int* posX     = mPosX.data();
+    int* posY     = mPosY.data();
+    const int* vX = mVX.data();
+    const int* vY = mVY.data();
+    for (unsigned int i = begin; i < n; i++)
+    {
+        posX[i] += vX[i];
+        posY[i] += vY[i];
+    }
+
+    unsigned int* frame      = mFrame.data();
+    unsigned int* ticks      = mFrameTicks.data();
+    const unsigned int* type = mType.data();
+    const unsigned int* nSprites  = mTypeNSprites.data();
+    const unsigned int* first     = mTypeDurations.data();
+    const unsigned int* durations = mDurations.data();
+    for (unsigned int i = begin; i < n; i++)
+    {
+        if (--ticks[i] > 0)
+        {
+            continue;
+        }
+
+        // Wrap around without a division
+        unsigned int next = frame[i] + 1;
+        frame[i] = (next < nSprites[type[i]]) ? next : 0;
+        ticks[i] = durations[first[type[i]] + frame[i]];
+    }
+}
+
+/**
+ * @brief Queue every entity in a sprite batch
+ * Lower layers are drawn first.
+ */
+void EntityStore::draw(SpriteBatch& batch, int layer, double alpha) const
+{
+    unsigned int n = mPosX.size();
+    for (unsigned int i = 0; i < n; i++)
+    {
+        unsigned int type = mType[i];
+        int width  = mTypeWidth[type];
+        int height = mTypeHeight[type];
+
+        //Clipping - grabbing the correct sprite from sheet
+        SDL_Rect spriteLimits = { (int)(width*mFrame[i]), 0, width, height };
+
+        //Render sprite to the right position
+        SDL_Rect renderQuad;
+        renderQuad.x = mPrevPosX[i] + (int)((mPosX[i] - mPrevPosX[i])*alpha);
+        renderQuad.y = mPrevPosY[i] + (int)((mPosY[i] - mPrevPosY[i])*alpha);
+        renderQuad.w = width;
+        renderQuad.h = height;
+
+        batch.draw(mTypeSheet[type].get(), spriteLimits, renderQuad, layer);
+    }
+}
+
+/**
+ * @brief Add every entity, with its previous and current position, to a snapshot
+ */
+void EntityStore::snapshot(StateSnapshot& snapshot, int layer) const
+{
+    unsigned int n = mPosX.size();
+    for (unsigned int i = 0; i < n; i++)
+    {
+        unsigned int type = mType[i];
+        int width  = mTypeWidth[type];
+        int height = mTypeHeight[type];
+
+        SDL_Rect spriteLimits = { (int)(width*mFrame[i]), 0, width, height };
+
+        snapshot.add(mTypeSheet[type].get(), spriteLimits, mPrevPosX[i], mPrevPosY[i],
+                     mPosX[i], mPosY[i], layer);
+    }
+}
+
+/**
+ * @brief Move last entity to index i and drop the last entity
+ * The slot of the removed entity gets a new generation, which invalidates
+ * all handles to it, and is put on the free list.
+ */
+void EntityStore::swapAndPop(unsigned int i)
+{
+    unsigned int last = mPosX.size() - 1;
+
+    // Retire slot of the removed entity (generation 0 is never valid)
+    unsigned int slot = mSlot[i];
+    mSlotGeneration[slot]++;
+    if (0 == mSlotGeneration[slot])
+    {
+        mSlotGeneration[slot] = 1;
+    }
+    mFreeSlots.push_back(slot);
+
+    if (i != last)
+    {
+        mPosX[i]     = mPosX[last];
+        mPosY[i]     = mPosY[last];
+        mPrevPosX[i] = mPrevPosX[last];
+        mPrevPosY[i] = mPrevPosY[last];
+        mVX[i]       = mVX[last];
+        mVY[i]       = mVY[last];
+        mFrame[i]    = mFrame[last];
+        mFrameTicks[i] = mFrameTicks[last];
+        mType[i]     = mType[last];
+        mSlot[i]     = mSlot[last];
+        mDead[i]     = mDead[last];
+
+        mSlotIndex[mSlot[i]] = i;
+    }
+
+    mPosX.pop_back();
+    mPosY.pop_back();
+    mPrevPosX.pop_back();
+    mPrevPosY.pop_back();
+    mVX.pop_back();
+    mVY.pop_back();
+    mFrame.pop_back();
+    mFrameTicks.pop_back();
+    mType.pop_back();
+    mSlot.pop_back();
+    mDead.pop_back();
+}
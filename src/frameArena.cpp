@@ -0,0 +1,140 @@
+/**
+ * @file
+ *
+ * @brief Defines a per-frame scratch memory arena
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "frameArena.h"
+
+/**
+ * @class Bump allocator for scratch data which only lives for one frame or
+ * tick (e.g. collision pair lists). Allocating is moving a pointer and
+ * everything is released at once by reset(), nothing is ever freed one by
+ * one and no destructors are run, so only plain types belong here.
+ *
+ * When a frame needs more than the block holds the rest comes from the
+ * heap, and the next reset replaces the block by one as large as the high
+ * water mark. So after a few frames there is no heap traffic at all.
+ */
+FrameArena::FrameArena(size_t capacity)
+    :mBlock(new unsigned char[capacity > 0 ? capacity : 1]),
+     mCapacity(capacity),
+     mUsed(0),
+     mOverflowed(0),
+     mHighWater(0),
+     mAllocations(0)
+{
+
+}
+
+// Destructor
+FrameArena::~FrameArena()
+{
+
+}
+
+/**
+ * @brief Get memory for the current frame
+ * @return Pointer valid until the next reset
+ */
+void* FrameArena::allocate(size_t bytes, size_t align)
+{
+    mAllocations++;
+
+    size_t offset = (mUsed + align - 1) & ~(align - 1);
+    if (offset + bytes <= mCapacity)
+    {
+        mUsed = offset + bytes;
+        return mBlock.get() + offset;
+    }
+
+    // Does not fit, new[] is aligned for any plain type
+    mOverflow.push_back(std::unique_ptr<unsigned char[]>(new unsigned char[bytes > 0 ? bytes : 1]));
+    mOverflowed += bytes;
+    return mOverflow.back().get();
+}
+
+/**
+ * @brief Release everything allocated this frame
+ * Grows the block if this frame did not fit into it.
+ */
+void FrameArena::reset()
+{
+    size_t used = mUsed + mOverflowed;
+    if (used > mHighWater)
+    {
+        mHighWater = used;
+    }
+
+    if (!mOverflow.empty())
+    {
+        mOverflow.clear();
+        mBlock.reset(new unsigned char[mHighWater]);
+        mCapacity = mHighWater;
+    }
+
+    mUsed        = 0;
+    mOverflowed  = 0;
+    mAllocations = 0;
+}
+
+/**
+ * @brief Get size of the main block in bytes
+ */
+size_t FrameArena::getCapacity() const
+{
+    return mCapacity;
+}
+
+/**
+ * @brief Get bytes allocated this frame
+ */
+size_t FrameArena::getUsed() const
+{
+    return mUsed + mOverflowed;
+}
+
+/**
+ * @brief Get most bytes allocated in one frame, not counting the current one
+ */
+size_t FrameArena::getHighWater() const
+{
+    return mHighWater;
+}
+
+/**
+ * @brief Get number of allocations this frame
+ */
+unsigned int FrameArena::getAllocations() const
+{
+    return mAllocations;
+}
+
+/**
+ * @brief Get number of allocations this frame which came from the heap
+ */
+unsigned int FrameArena::getOverflows() const
+{
+    return mOverflow.size();
+}
@@ -1,26 +1,187 @@
-/**
- * @file
- *
- * @brief Defines class for holding game data
- *
- * @author Alexandre Lopes
- *
- * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
- *
- */
-
-/* This file is part of EngineZ.
- *
- * EngineZ is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License as published by
- * the Free Software Foundation, either version 3 of the License, or
- * (at your option) any later version.
- *
- * EngineZ is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- * GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License
- * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
- */
+/**
+ * @file
+ *
+ * @brief Defines class for holding game data
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "game.h"
+
+/**
+ * @class Game loop timing. The simulation advances in fixed ticks, no matter
+ * how fast frames are rendered. Frame time is accumulated and consumed in
+ * tick sized steps; whatever is left over is used to interpolate between
+ * the last two ticks when drawing.
+ *
+ * Usage:
+ * @code
+ * game.beginFrame();
+ * while (game.tick())
+ * {
+ *     // advance simulation by getDt()
+ * }
+ * // draw using getAlpha()
+ * game.endFrame();
+ * @endcode
+ */
+Game::Game(unsigned int tickRate, unsigned int maxFps)
+{
+    // A tick rate of 0 would never advance the simulation
+    if (0 == tickRate)
+    {
+        tickRate = 1;
+    }
+
+    mTickRate    = tickRate;
+    mMaxFps      = maxFps;
+    mDt          = 1.0/tickRate;
+    mAccumulator = 0;
+    mFrequency   = SDL_GetPerformanceFrequency();
+    mFrameStart  = SDL_GetPerformanceCounter();
+    mTickTime    = mFrameStart;
+    mTicks       = 0;
+}
+
+// Destructor
+Game::~Game()
+{
+
+}
+
+/**
+ * @brief Start a new frame
+ * Adds the time elapsed since the previous frame to the accumulator.
+ */
+void Game::beginFrame()
+{
+    Uint64 now       = SDL_GetPerformanceCounter();
+    double frameTime = (double)(now - mFrameStart)/mFrequency;
+    mFrameStart      = now;
+
+    // Never owe the simulation more than MAX_FRAME_TIME, also when the
+    // caller only uses the frame rate cap and never ticks
+    mAccumulator += frameTime;
+    if (mAccumulator > MAX_FRAME_TIME)
+    {
+        mAccumulator = MAX_FRAME_TIME;
+    }
+}
+
+/**
+ * @brief Consume one simulation tick
+ * @return true if a tick is due, false once the simulation caught up
+ * with real time
+ */
+bool Game::tick()
+{
+    if (mAccumulator >= mDt)
+    {
+        mAccumulator -= mDt;
+        mTickTime     = mFrameStart - (Uint64)(mAccumulator*mFrequency);
+        mTicks++;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief End frame
+ * If a frame rate cap is set, waits for the remainder of the frame. This
+ * keeps the game from spinning at full speed when there is no vsync.
+ */
+void Game::endFrame()
+{
+    if (0 == mMaxFps)
+    {
+        return;
+    }
+
+    double minFrameTime = 1.0/mMaxFps;
+    double elapsed      = (double)(SDL_GetPerformanceCounter() - mFrameStart)/mFrequency;
+
+    if (elapsed < minFrameTime)
+    {
+        SDL_Delay((Uint32)((minFrameTime - elapsed)*1000));
+    }
+}
+
+/**
+ * @brief Get interpolation factor
+ * 0 means the state of the previous tick, 1 the state of the current one.
+ */
+double Game::getAlpha() const
+{
+    return mAccumulator/mDt;
+}
+
+/**
+ * @brief Get duration of a simulation tick in seconds
+ */
+double Game::getDt() const
+{
+    return mDt;
+}
+
+/**
+ * @brief Get number of simulation ticks per second
+ */
+unsigned int Game::getTickRate() const
+{
+    return mTickRate;
+}
+
+/**
+ * @brief Get frame rate cap
+ */
+unsigned int Game::getMaxFps() const
+{
+    return mMaxFps;
+}
+
+/**
+ * @brief Get number of simulation ticks run so far
+ */
+unsigned long Game::getTicks() const
+{
+    return mTicks;
+}
+
+/**
+ * @brief Get time the last tick consumed is due at
+ * The simulation lags the frame start by the time left in the
+ * accumulator, so the ticks of a frame are due one tick apart, up to the
+ * frame start. Input for a tick is whatever happened before this time.
+ */
+Uint64 Game::getTickTime() const
+{
+    return mTickTime;
+}
+
+/**
+ * @brief Set frame rate cap (0 means uncapped)
+ */
+void Game::setMaxFps(unsigned int maxFps)
+{
+    mMaxFps = maxFps;
+}
@@ -41,3 +41,12 @@ SDL_Renderer* renderer = NULL;
 
 //Chroma key
 int COLOR_KEY[3] = {0, 255, 0}; 
+
+//Simulation ticks per second
+unsigned int TICK_RATE = 60;
+
+//Frame rate cap (0 means uncapped)
+unsigned int MAX_FPS = 300;
+
+//Audio mixer buffer size in sample frames
+unsigned int AUDIO_BUFFER = 2048;
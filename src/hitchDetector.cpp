@@ -0,0 +1,311 @@
+/**
+ * @file
+ *
+ * @brief Defines the frame hitch detector and heap allocation counting
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "hitchDetector.h"
+#include "assetCache.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+//@{
+/*
+    Heap allocations and bytes allocated so far, by every thread
+ */
+static std::atomic<unsigned long> allocations(0);
+static std::atomic<unsigned long> allocatedBytes(0);
+//@}
+
+/**
+ * @brief Counting global operator new
+ * Every heap allocation of the program goes through here (the array and
+ * nothrow versions call it), so a frame's allocations can be attributed
+ * to it. Counting is two relaxed atomic increments.
+ */
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+    void* p = malloc(size ? size : 1);
+    if (p == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+/**
+ * @brief Get number of heap allocations so far
+ */
+unsigned long getAllocations()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Get number of bytes allocated on the heap so far
+ * Bytes freed again are not subtracted.
+ */
+unsigned long getAllocatedBytes()
+{
+    return allocatedBytes.load(std::memory_order_relaxed);
+}
+
+/**
+ * @class Flags frames over budget and records what happened in them:
+ * time spent in each phase of the frame, heap allocations (by any
+ * thread), asset loads (asset cache misses), number of entities and
+ * simulation ticks run.
+ *
+ * Frames are split into phases with lap(). Hitches are appended to a CSV
+ * log, one line per hitch; once it has HITCH_LOG_LINES lines it is moved
+ * to FILE.1 and a new one is started, so the log never grows unbounded.
+ * Unlike the profiler this is always compiled in, it costs a few counter
+ * reads per frame.
+ */
+HitchDetector::HitchDetector(double budget)
+    :mBudget(budget),
+     mFrequency(SDL_GetPerformanceFrequency()),
+     mStart(SDL_GetPerformanceCounter()),
+     mFrameStart(mStart),
+     mLapStart(mStart),
+     mNPhases(0),
+     mAllocations(0),
+     mBytes(0),
+     mLoads(0),
+     mTicks(0),
+     mFrames(0),
+     mHitches(0),
+     mWorst(0),
+     mLog(NULL),
+     mLines(0)
+{
+
+}
+
+/**
+ * @brief Destructor - closes the log
+ */
+HitchDetector::~HitchDetector()
+{
+    if (mLog != NULL)
+    {
+        fclose(mLog);
+    }
+}
+
+/**
+ * @brief Log hitches to a file
+ * The file is overwritten.
+ */
+bool HitchDetector::open(const std::string& filename)
+{
+    if (mLog != NULL)
+    {
+        fclose(mLog);
+    }
+
+    mFilename = filename;
+    mLines    = 0;
+    mLog      = fopen(filename.c_str(), "w");
+    if (mLog == NULL)
+    {
+        printf( "Could not create hitch log %s!\n", filename.c_str() );
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Start a frame
+ * The first phase starts here too.
+ */
+void HitchDetector::beginFrame()
+{
+    mFrameStart  = SDL_GetPerformanceCounter();
+    mLapStart    = mFrameStart;
+    mNPhases     = 0;
+    mAllocations = getAllocations();
+    mBytes       = getAllocatedBytes();
+    mLoads       = assetCache.getMisses();
+}
+
+/**
+ * @brief End current phase of the frame and start the next one
+ * phase names the phase just ended and must outlive the frame (e.g. a
+ * string literal). Phases beyond HITCH_MAX_PHASES are added to the last.
+ */
+void HitchDetector::lap(const char* phase)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+
+    if (mNPhases < HITCH_MAX_PHASES)
+    {
+        mPhases[mNPhases]    = phase;
+        mPhaseTime[mNPhases] = now - mLapStart;
+        mNPhases++;
+    }
+    else
+    {
+        mPhaseTime[HITCH_MAX_PHASES - 1] += now - mLapStart;
+    }
+
+    mLapStart = now;
+}
+
+/**
+ * @brief End the frame
+ * @param entities Number of entities alive
+ * @param ticks Number of simulation ticks run so far
+ * @return Whether the frame took longer than the budget
+ */
+bool HitchDetector::endFrame(unsigned int entities, unsigned long ticks)
+{
+    double frameTime = toMs(SDL_GetPerformanceCounter() - mFrameStart);
+    unsigned long ticksRun = ticks - mTicks;
+
+    mTicks = ticks;
+    mFrames++;
+    mWorst = std::max(mWorst, frameTime);
+
+    if (frameTime <= mBudget)
+    {
+        return false;
+    }
+
+    mHitches++;
+    if (mLog != NULL)
+    {
+        write(frameTime, getAllocations() - mAllocations, getAllocatedBytes() - mBytes,
+              assetCache.getMisses() - mLoads, entities, ticksRun);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Get frame budget in ms
+ */
+double HitchDetector::getBudget() const
+{
+    return mBudget;
+}
+
+/**
+ * @brief Set frame budget in ms
+ */
+void HitchDetector::setBudget(double budget)
+{
+    mBudget = budget;
+}
+
+/**
+ * @brief Get number of frames so far
+ */
+unsigned long HitchDetector::getFrames() const
+{
+    return mFrames;
+}
+
+/**
+ * @brief Get number of hitches so far
+ */
+unsigned long HitchDetector::getHitches() const
+{
+    return mHitches;
+}
+
+/**
+ * @brief Get longest frame so far in ms
+ */
+double HitchDetector::getWorst() const
+{
+    return mWorst;
+}
+
+/**
+ * @brief Convert performance counter ticks to ms
+ */
+double HitchDetector::toMs(Uint64 time) const
+{
+    return 1000.0*time/mFrequency;
+}
+
+/**
+ * @brief Write a hitch to the log
+ * Each log starts with a header naming the columns, phase columns are
+ * named after the phases of the first hitch written to it.
+ */
+void HitchDetector::write(double frameTime, unsigned long allocations, unsigned long bytes,
+                          unsigned long loads, unsigned int entities, unsigned long ticks)
+{
+    if (mLines >= HITCH_LOG_LINES)
+    {
+        fclose(mLog);
+        std::string old = mFilename + ".1";
+        remove(old.c_str());
+        rename(mFilename.c_str(), old.c_str());
+
+        mLines = 0;
+        mLog   = fopen(mFilename.c_str(), "w");
+        if (mLog == NULL)
+        {
+            printf( "Could not create hitch log %s!\n", mFilename.c_str() );
+            return;
+        }
+    }
+
+    if (0 == mLines)
+    {
+        fprintf(mLog, "frame,time_s,frame_ms,allocations,allocated_bytes,asset_loads,entities,ticks");
+        for (unsigned int i = 0; i < mNPhases; i++)
+        {
+            fprintf(mLog, ",%s_ms", mPhases[i]);
+        }
+        fprintf(mLog, "\n");
+        mLines++;
+    }
+
+    fprintf(mLog, "%lu,%.3f,%.3f,%lu,%lu,%lu,%u,%lu", mFrames, toMs(mFrameStart - mStart)/1000.0,
+            frameTime, allocations, bytes, loads, entities, ticks);
+    for (unsigned int i = 0; i < mNPhases; i++)
+    {
+        fprintf(mLog, ",%.3f", toMs(mPhaseTime[i]));
+    }
+    fprintf(mLog, "\n");
+    mLines++;
+
+    // Hitches are rare, flush so the log survives a crash or a kill
+    fflush(mLog);
+}
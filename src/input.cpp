@@ -0,0 +1,373 @@
+/**
+ * @file
+ *
+ * @brief Defines the input layer, turning key events into timestamped actions
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "input.h"
+
+//Names of the actions in binding files, in Action order
+static const char* actionNames[N_ACTIONS] =
+{
+    "up",
+    "down",
+    "left",
+    "right"
+};
+
+/**
+ * @class Input layer between SDL's event queue and the simulation. The
+ * main thread, which owns the event queue, passes every event it polls
+ * to handleEvent(); key events bound to an action are queued with the
+ * time they happened. Each simulation tick then applies the events up to
+ * its own time with update(), on whatever thread it runs on. So input is
+ * consumed at a fixed tick rate, and a tick sees exactly the events
+ * which happened before it, however late it actually runs.
+ *
+ * An action pressed and released again between two ticks is still active
+ * for one tick, short taps are not lost.
+ *
+ * Keys are bound to actions by a table, see bind() and loadBindings().
+ *
+ * Latency from an event to the present of the first frame showing its
+ * effect is measured by passing the time returned by getAppliedTime()
+ * along with the tick's result (e.g. in its StateSnapshot) to
+ * presented().
+ */
+Input::Input()
+    :mBindings(SDL_NUM_SCANCODES, -1),
+     mHeld(0),
+     mApplied(0),
+     mFrequency(SDL_GetPerformanceFrequency()),
+     mLatencyMode(false),
+     mLastPresented(0),
+     mLatencyCount(0),
+     mLatencySum(0),
+     mLatencyMax(0)
+{
+    for (unsigned int a = 0; a < N_ACTIONS; a++)
+    {
+        mDown[a] = 0;
+    }
+
+    bind(SDL_SCANCODE_UP, ACTION_UP);
+    bind(SDL_SCANCODE_DOWN, ACTION_DOWN);
+    bind(SDL_SCANCODE_LEFT, ACTION_LEFT);
+    bind(SDL_SCANCODE_RIGHT, ACTION_RIGHT);
+}
+
+// Destructor
+Input::~Input()
+{
+
+}
+
+/**
+ * @brief Bind a key to an action
+ * A key triggers one action only, the one it was bound to last. An
+ * action may have any number of keys.
+ */
+void Input::bind(SDL_Scancode key, Action action)
+{
+    if (((int)key < 0) || ((unsigned int)key >= mBindings.size()))
+    {
+        throw std::out_of_range(" Invalid key!");
+    }
+    if ((unsigned int)action >= N_ACTIONS)
+    {
+        throw std::out_of_range(" Invalid action!");
+    }
+
+    mBindings[key] = action;
+}
+
+/**
+ * @brief Remove every key bound to an action
+ */
+void Input::unbind(Action action)
+{
+    std::replace(mBindings.begin(), mBindings.end(), (int)action, -1);
+}
+
+/**
+ * @brief Get keys bound to an action
+ */
+std::vector<SDL_Scancode> Input::getKeys(Action action) const
+{
+    std::vector<SDL_Scancode> keys;
+    for (unsigned int k = 0; k < mBindings.size(); k++)
+    {
+        if (mBindings[k] == (int)action)
+        {
+            keys.push_back((SDL_Scancode)k);
+        }
+    }
+
+    return keys;
+}
+
+/**
+ * @brief Load key bindings from a text file
+ * One binding per line, the action name followed by the key name as
+ * given by SDL_GetScancodeName(), e.g. "up W" or "left Keypad 4". Lines
+ * starting with # are comments. An action listed in the file loses its
+ * previous keys, the others keep theirs. Bad lines are reported and
+ * skipped.
+ * @return false if the file could not be read
+ */
+bool Input::loadBindings(const std::string& filename)
+{
+    FILE* file = fopen(filename.c_str(), "r");
+    if (file == NULL)
+    {
+        printf( "Unable to load key bindings %s!\n", filename.c_str() );
+        return false;
+    }
+
+    bool listed[N_ACTIONS] = { false };
+    char line[256];
+    unsigned int lineNumber = 0;
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        lineNumber++;
+
+        std::string text = line;
+        std::string::size_type end = text.find_last_not_of(" \t\r\n");
+        std::string::size_type begin = text.find_first_not_of(" \t");
+        if ((end == std::string::npos) || (text[begin] == '#'))
+        {
+            continue;
+        }
+        text = text.substr(begin, end - begin + 1);
+
+        std::string::size_type split = text.find_first_of(" \t");
+        std::string name = text.substr(0, split);
+        std::string keyName;
+        if (split != std::string::npos)
+        {
+            keyName = text.substr(text.find_first_not_of(" \t", split));
+        }
+
+        int action = 0;
+        while ((action < N_ACTIONS) && (name != actionNames[action]))
+        {
+            action++;
+        }
+        SDL_Scancode key = SDL_GetScancodeFromName(keyName.c_str());
+        if ((action == N_ACTIONS) || (key == SDL_SCANCODE_UNKNOWN))
+        {
+            printf( "%s:%u: invalid key binding \"%s\"!\n", filename.c_str(), lineNumber, text.c_str() );
+            continue;
+        }
+
+        if (!listed[action])
+        {
+            unbind((Action)action);
+            listed[action] = true;
+        }
+        bind(key, (Action)action);
+    }
+
+    fclose(file);
+    return true;
+}
+
+/**
+ * @brief Queue the action of a key event
+ * Key repeats are ignored, and with several keys bound to an action only
+ * the first press and last release count. The event time is SDL's
+ * timestamp, i.e. when SDL received it rather than when it was polled.
+ * @return true if the event was a key bound to an action
+ */
+bool Input::handleEvent(const SDL_Event& event)
+{
+    if ((event.type != SDL_KEYDOWN) && (event.type != SDL_KEYUP))
+    {
+        return false;
+    }
+
+    SDL_Scancode key = event.key.keysym.scancode;
+    if (((int)key < 0) || ((unsigned int)key >= mBindings.size()) || (mBindings[key] < 0))
+    {
+        return false;
+    }
+    if (event.key.repeat)
+    {
+        return true;
+    }
+
+    InputEvent input;
+    input.action  = (Action)mBindings[key];
+    input.pressed = (event.type == SDL_KEYDOWN);
+
+    if (input.pressed)
+    {
+        if (mDown[input.action]++ > 0)
+        {
+            return true;
+        }
+    }
+    else
+    {
+        if ((mDown[input.action] == 0) || (--mDown[input.action] > 0))
+        {
+            return true;
+        }
+    }
+
+    //SDL timestamps are in ms since SDL_Init, move back from now by the
+    //time the event spent in SDL's queue
+    Uint64 now = SDL_GetPerformanceCounter();
+    Uint64 age = (Uint64)(Uint32)(SDL_GetTicks() - event.key.timestamp)*mFrequency/1000;
+    input.time = now - std::min(age, now);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    //Keep the queue in time order, the ms resolution of SDL's timestamps
+    //may put an event slightly before the one queued last
+    if (!mQueue.empty())
+    {
+        input.time = std::max(input.time, mQueue.back().time);
+    }
+    mQueue.push_back(input);
+
+    return true;
+}
+
+/**
+ * @brief Apply events up to a time
+ * Called once per simulation tick with the tick's time, by the thread
+ * running the simulation. Later events stay queued for later ticks.
+ * @return Actions held, plus actions pressed since the last update
+ */
+ActionSet Input::update(Uint64 until)
+{
+    ActionSet pressed = 0;
+    mApplied = 0;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    while (!mQueue.empty() && (mQueue.front().time <= until))
+    {
+        const InputEvent& input = mQueue.front();
+        if (input.pressed)
+        {
+            mHeld   |= ACTION_BIT(input.action);
+            pressed |= ACTION_BIT(input.action);
+        }
+        else
+        {
+            mHeld &= ~ACTION_BIT(input.action);
+        }
+        if (mApplied == 0)
+        {
+            mApplied = input.time;
+        }
+        mQueue.pop_front();
+    }
+
+    return mHeld | pressed;
+}
+
+/**
+ * @brief Get time of the oldest event applied by the last update
+ * @return Performance counter time, 0 if no event was applied
+ */
+Uint64 Input::getAppliedTime() const
+{
+    return mApplied;
+}
+
+/**
+ * @brief Report that a frame showing input of a given time was presented
+ * Call right after SDL_RenderPresent() with the input time of the state
+ * drawn. The same input time is measured once only, in the first frame
+ * showing it; 0 (no input) is ignored.
+ */
+void Input::presented(Uint64 inputTime)
+{
+    if ((inputTime == 0) || (inputTime <= mLastPresented))
+    {
+        return;
+    }
+    mLastPresented = inputTime;
+
+    Uint64 latency = SDL_GetPerformanceCounter() - inputTime;
+    mLatencyCount++;
+    mLatencySum += latency;
+    mLatencyMax  = std::max(mLatencyMax, latency);
+
+    if (mLatencyMode)
+    {
+        printf( "Input latency: %.2f ms\n", 1000.0*latency/mFrequency );
+    }
+}
+
+/**
+ * @brief Print every latency measurement
+ */
+void Input::setLatencyMode(bool latencyMode)
+{
+    mLatencyMode = latencyMode;
+}
+
+/**
+ * @brief Get number of latency measurements
+ */
+unsigned long Input::getLatencyCount() const
+{
+    return mLatencyCount;
+}
+
+/**
+ * @brief Get average latency from event to present in ms
+ */
+double Input::getLatencyAverage() const
+{
+    if (mLatencyCount == 0)
+    {
+        return 0;
+    }
+
+    return 1000.0*mLatencySum/mLatencyCount/mFrequency;
+}
+
+/**
+ * @brief Get maximum latency from event to present in ms
+ */
+double Input::getLatencyMax() const
+{
+    return 1000.0*mLatencyMax/mFrequency;
+}
+
+/**
+ * @brief Get name of an action, as used in binding files
+ */
+const char* Input::getName(Action action)
+{
+    if ((unsigned int)action >= N_ACTIONS)
+    {
+        throw std::out_of_range(" Invalid action!");
+    }
+
+    return actionNames[action];
+}
@@ -0,0 +1,387 @@
+/**
+ * @file
+ *
+ * @brief Defines a work-stealing job system
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "jobSystem.h"
+
+// Queue of the current thread, 0 for threads which are not workers
+static thread_local unsigned int queueIndex = 0;
+
+// Jobs released by the job the current thread just ran, kept between jobs
+// so that it does not allocate once it is large enough
+static thread_local std::vector<JobId> released;
+
+/**
+ * @class Work-stealing job system. Each worker thread has its own queue;
+ * it takes work from the back of it (most recent, still in cache) and when
+ * it runs dry steals from the front of the other queues. Jobs may depend
+ * on other jobs and only get queued once those are done, so systems can
+ * be chained, e.g. movement -> broad phase -> narrow phase.
+ *
+ * Jobs live in a fixed array and are forgotten all at once by reset(), and
+ * the dependency lists of the slots keep their capacity, so once running
+ * no memory is allocated per job except by a std::function too large for
+ * its small object buffer (with libstdc++ more than two pointers, so a
+ * lambda capturing this and a reference is fine). Parallel for chunks
+ * share the caller's body, stored with their range in the job slot.
+ *
+ * @note Jobs must not throw.
+ */
+JobSystem::JobSystem(unsigned int nThreads)
+    :mJobs(new Job[JOB_CAPACITY]),
+     mQueues(nThreads + 1),
+     mLocks(new std::mutex[nThreads + 1])
+{
+    mNJobs.store(0);
+    mQueued.store(0);
+    mRunning.store(true);
+
+    for (unsigned int i = 0; i < mQueues.size(); i++)
+    {
+        mQueues[i].jobs.resize(JOB_CAPACITY);
+        mQueues[i].first = 0;
+        mQueues[i].size  = 0;
+    }
+
+    for (unsigned int i = 0; i < nThreads; i++)
+    {
+        mThreads.push_back(std::thread(&JobSystem::work, this, i + 1));
+    }
+}
+
+// Destructor
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> guard(mSleep);
+        mRunning.store(false);
+    }
+    mWake.notify_all();
+
+    for (unsigned int i = 0; i < mThreads.size(); i++)
+    {
+        mThreads[i].join();
+    }
+}
+
+/**
+ * @brief Add a job
+ * It is queued right away unless after is a job which is not done yet.
+ */
+JobId JobSystem::add(const std::function<void()>& work, JobId after)
+{
+    JobId job = create();
+    mJobs[job].work = work;
+    depend(job, after);
+    release(job);
+
+    return job;
+}
+
+/**
+ * @brief Add a job depending on several jobs
+ */
+JobId JobSystem::add(const std::function<void()>& work, const std::vector<JobId>& after)
+{
+    JobId job = create();
+    mJobs[job].work = work;
+    for (unsigned int i = 0; i < after.size(); i++)
+    {
+        depend(job, after[i]);
+    }
+    release(job);
+
+    return job;
+}
+
+/**
+ * @brief Parallel for loop
+ * [begin, end) is split into about four chunks per thread, but no chunk is
+ * smaller than grain. Every chunk is a job depending on after. The job
+ * returned is created first and made to wait for each chunk as it is
+ * added, so no list of chunks is needed.
+ * @return Job which is done once every chunk is done
+ */
+JobId JobSystem::parallelFor(unsigned int begin, unsigned int end, unsigned int grain,
+                             const std::function<void(unsigned int, unsigned int)>& body,
+                             JobId after)
+{
+    JobId done = create();
+
+    if (end > begin)
+    {
+        unsigned int n     = end - begin;
+        unsigned int chunk = std::max(std::max(grain, 1u), n/(4*(unsigned int)mQueues.size()) + 1);
+
+        for (unsigned int first = begin; first < end; first += chunk)
+        {
+            JobId job = create();
+            Job& entry = mJobs[job];
+            entry.body  = body;
+            entry.first = first;
+            entry.last  = std::min(end, first + chunk);
+
+            depend(job, after);
+            depend(done, job);
+            release(job);
+        }
+    }
+    else
+    {
+        depend(done, after);
+    }
+
+    release(done);
+
+    return done;
+}
+
+/**
+ * @brief Wait for a job
+ * The calling thread runs queued jobs while waiting, so waiting from the
+ * main thread with no workers runs everything.
+ */
+void JobSystem::wait(JobId job)
+{
+    if (job == NO_JOB)
+    {
+        return;
+    }
+
+    while (!mJobs[job].done.load())
+    {
+        JobId next = dequeue();
+        if (next != NO_JOB)
+        {
+            run(next);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+/**
+ * @brief Forget all jobs
+ * Every job added so far must have run (e.g. after waiting for the last
+ * one of a frame). A job is only marked done after releasing its
+ * dependents, so the last job can be done while others still finish their
+ * bookkeeping; those are waited for here, before their slots are reused.
+ */
+void JobSystem::reset()
+{
+    unsigned int n = std::min(mNJobs.load(), (unsigned int)JOB_CAPACITY);
+    for (unsigned int i = 0; i < n; i++)
+    {
+        while (!mJobs[i].done.load())
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    mNJobs.store(0);
+}
+
+/**
+ * @brief Get number of worker threads
+ */
+unsigned int JobSystem::getNThreads() const
+{
+    return mThreads.size();
+}
+
+/**
+ * @brief Create a job
+ * The job waits for one extra release, so that dependencies can be added
+ * before it can possibly run.
+ */
+JobId JobSystem::create()
+{
+    JobId job = mNJobs++;
+    if (job >= JOB_CAPACITY)
+    {
+        throw std::length_error(" Too many jobs, call JobSystem::reset!");
+    }
+
+    Job& entry = mJobs[job];
+    std::lock_guard<std::mutex> guard(entry.lock);
+    entry.work   = nullptr;
+    entry.body   = nullptr;
+    entry.waiting.store(1);
+    entry.done.store(false);
+    entry.closed = false;
+    entry.dependents.clear();
+
+    return job;
+}
+
+/**
+ * @brief Make a job wait for another one
+ */
+void JobSystem::depend(JobId job, JobId after)
+{
+    if (after == NO_JOB)
+    {
+        return;
+    }
+
+    Job& dependency = mJobs[after];
+    std::lock_guard<std::mutex> guard(dependency.lock);
+    if (!dependency.closed)
+    {
+        mJobs[job].waiting++;
+        dependency.dependents.push_back(job);
+    }
+}
+
+/**
+ * @brief A dependency of a job is done
+ */
+void JobSystem::release(JobId job)
+{
+    if (0 == --mJobs[job].waiting)
+    {
+        enqueue(job);
+    }
+}
+
+/**
+ * @brief Put a job in the queue of the calling thread
+ */
+void JobSystem::enqueue(JobId job)
+{
+    {
+        std::lock_guard<std::mutex> guard(mLocks[queueIndex]);
+        Queue& queue = mQueues[queueIndex];
+        queue.jobs[(queue.first + queue.size) % JOB_CAPACITY] = job;
+        queue.size++;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(mSleep);
+        mQueued++;
+    }
+    mWake.notify_one();
+}
+
+/**
+ * @brief Take a job
+ * From the back of the own queue first, otherwise from the front of
+ * another queue.
+ */
+JobId JobSystem::dequeue()
+{
+    unsigned int n = mQueues.size();
+
+    for (unsigned int k = 0; k < n; k++)
+    {
+        unsigned int index = (queueIndex + k) % n;
+
+        std::lock_guard<std::mutex> guard(mLocks[index]);
+        Queue& queue = mQueues[index];
+        if (0 == queue.size)
+        {
+            continue;
+        }
+
+        JobId job;
+        if (0 == k)
+        {
+            job = queue.jobs[(queue.first + queue.size - 1) % JOB_CAPACITY];
+        }
+        else
+        {
+            job = queue.jobs[queue.first];
+            queue.first = (queue.first + 1) % JOB_CAPACITY;
+        }
+        queue.size--;
+        mQueued--;
+
+        return job;
+    }
+
+    return NO_JOB;
+}
+
+/**
+ * @brief Run a job and release the jobs waiting for it
+ */
+void JobSystem::run(JobId job)
+{
+    Job& entry = mJobs[job];
+    if (entry.body)
+    {
+        entry.body(entry.first, entry.last);
+    }
+    else if (entry.work)
+    {
+        entry.work();
+    }
+
+    // Closed to new dependents, which are released outside the lock. The
+    // list is copied and cleared, not swapped, so it keeps its capacity.
+    {
+        std::lock_guard<std::mutex> guard(entry.lock);
+        entry.closed = true;
+        released.assign(entry.dependents.begin(), entry.dependents.end());
+        entry.dependents.clear();
+    }
+
+    for (unsigned int i = 0; i < released.size(); i++)
+    {
+        release(released[i]);
+    }
+
+    // Last touch of the slot, it may be reused once this is seen
+    entry.done.store(true);
+}
+
+/**
+ * @brief Worker thread main loop
+ * Sleeps while there is nothing queued.
+ */
+void JobSystem::work(unsigned int index)
+{
+    queueIndex = index;
+
+    while (true)
+    {
+        JobId job = dequeue();
+        if (job != NO_JOB)
+        {
+            run(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(mSleep);
+        mWake.wait(guard, [this]{ return (mQueued.load() > 0) || !mRunning.load(); });
+        if (!mRunning.load())
+        {
+            return;
+        }
+    }
+}
@@ -26,29 +26,163 @@
  */
  
 #include <stdio.h>
-#include <iostream>
-#include <vector>
+#include <stdlib.h>
+#include <algorithm>
 #include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
 
 #include <SDL.h>
-#include <SDL_mixer.h>
 
 #include "sdlInit.h"
-#include "enemy.h"
-#include "user.h"
-#include "spriteFunctions.h"
-//#include "game.h"
+#include "simulation.h"
+#include "textureAtlas.h"
+#include "spriteBatch.h"
+#include "assetCache.h"
+#include "assetStreamer.h"
+#include "audio.h"
+#include "game.h"
+#include "pipeline.h"
+#include "jobSystem.h"
+#include "profiler.h"
+#include "hitchDetector.h"
+#include "input.h"
+#include "replay.h"
+#include "tilemap.h"
 
-//Game music
-Mix_Music *music = NULL;
+/**
+ * @brief Scrolling background, see data/level.map
+ */
+#define BACKGROUND_MAP DATADIR "/level.map"
+
+/**
+ * @brief Sprite batch layer of the background, below every sprite
+ */
+#define BACKGROUND_LAYER -1
 
+/**
+ * @brief Background scroll speed in pixels per tick
+ */
+#define BACKGROUND_SPEED 1
+
+/**
+ * @brief Main function
+ *
+ * Options:
+ *   --headless  no window, no audio, software rendering
+ *   --seed N    seed for the random number generator
+ *   --ticks N   quit after N simulation ticks
+ *   --single-thread  run the simulation on the main thread
+ *   --threads N  worker threads for the parallel simulation phases
+ *                (default: one per core not used by the main and
+ *                simulation threads)
+ *   --audio-buffer N  mixer buffer in sample frames, smaller is lower
+ *                     latency (default 2048)
+ *   --hitch-log FILE  log frames over budget, see HitchDetector
+ *   --hitch-budget MS frame budget (default: one refresh at 60 Hz)
+ *   --bindings FILE   key bindings, see Input::loadBindings()
+ *   --latency         print the latency from every input to its present
+ *   --record FILE     record the seed and the input of every tick
+ *   --replay FILE     re-run a recording headless, as fast as possible,
+ *                     and check it reaches the same states
+ *   --hash-log FILE   write the state hash after every tick, to diff runs
+ *
+ * With the profiler compiled in (configure --enable-profiler) also:
+ *   --profile-csv FILE    write per frame zone times on exit
+ *   --profile-trace FILE  write a Chrome trace of the last frames on exit
+ *   F3 toggles the profiler overlay
+ */
 int main(int argvc, char* argv[])
 {
     //Quit flag for game loop
     bool quit = false;
 
+    //Exit code, non-zero if a replay diverged from its recording
+    int status = 0;
+
+    //Command line options
+    bool headless      = false;
+    bool threaded      = true;
+    unsigned int seed  = std::default_random_engine::default_seed;
+    unsigned long maxTicks = 0;
+    unsigned int cores     = std::thread::hardware_concurrency();
+    unsigned int workers   = (cores > 2) ? cores - 2 : 0;
+    std::string profileCsv, profileTrace;
+    std::string hitchLog;
+    double hitchBudget     = HITCH_BUDGET;
+    std::string bindings;
+    bool latency           = false;
+    std::string recordFile, replayFile, hashLog;
+    for (int i = 1; i < argvc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--headless")
+        {
+            headless = true;
+        }
+        else if (arg == "--single-thread")
+        {
+            threaded = false;
+        }
+        else if ((arg == "--seed") && (i + 1 < argvc))
+        {
+            seed = strtoul(argv[++i], NULL, 10);
+        }
+        else if ((arg == "--threads") && (i + 1 < argvc))
+        {
+            workers = strtoul(argv[++i], NULL, 10);
+        }
+        else if ((arg == "--ticks") && (i + 1 < argvc))
+        {
+            maxTicks = strtoul(argv[++i], NULL, 10);
+        }
+        else if ((arg == "--audio-buffer") && (i + 1 < argvc))
+        {
+            AUDIO_BUFFER = strtoul(argv[++i], NULL, 10);
+        }
+        else if ((arg == "--hitch-log") && (i + 1 < argvc))
+        {
+            hitchLog = argv[++i];
+        }
+        else if ((arg == "--hitch-budget") && (i + 1 < argvc))
+        {
+            hitchBudget = strtod(argv[++i], NULL);
+        }
+        else if ((arg == "--bindings") && (i + 1 < argvc))
+        {
+            bindings = argv[++i];
+        }
+        else if (arg == "--latency")
+        {
+            latency = true;
+        }
+        else if ((arg == "--record") && (i + 1 < argvc))
+        {
+            recordFile = argv[++i];
+        }
+        else if ((arg == "--replay") && (i + 1 < argvc))
+        {
+            replayFile = argv[++i];
+            headless   = true;
+            threaded   = false;
+        }
+        else if ((arg == "--hash-log") && (i + 1 < argvc))
+        {
+            hashLog = argv[++i];
+        }
+        else if ((arg == "--profile-csv") && (i + 1 < argvc))
+        {
+            profileCsv = argv[++i];
+        }
+        else if ((arg == "--profile-trace") && (i + 1 < argvc))
+        {
+            profileTrace = argv[++i];
+        }
+    }
+
     //Start up SDL, create window and renderer
-    if( !sdlInit() )
+    if( !(headless ? sdlInitHeadless() : sdlInit()) )
     {
         printf( "Failed to initialize!\n" );
     }
@@ -56,134 +190,337 @@ int main(int argvc, char* argv[])
     {
         try
         {
-            //Load music
-            music = Mix_LoadMUS( DATADIR "/audio/576220_Dante-Rabanow.mp3" ); 
-            if( music == NULL ) 
-            { 
-                printf( "Failed to load music! SDL_mixer Error: %s\n", Mix_GetError() ); 
+            //Background loading, the music starts once it is loaded
+            //instead of holding up startup
+            AssetStreamer streamer(1);
+            StreamHandle music = 0;
+            bool musicStarted  = headless;
+            if (!headless)
+            {
+                music = streamer.requestMusic( DATADIR "/audio/576220_Dante-Rabanow.mp3" );
+            }
+
+            //Sound effects, decoded once up front
+            Audio audio;
+            SoundId hitSound = audio.load( DATADIR "/audio/hit.wav", 1 );
+
+            //Recording or replay, a replay brings its own seed
+            Replay replay;
+            if (!replayFile.empty())
+            {
+                try
+                {
+                    replay.load(replayFile);
+                }
+                catch (const std::exception& e)
+                {
+                    printf( "Unable to load recording %s!%s\n", replayFile.c_str(), e.what() );
+                    throw;
+                }
+                seed = replay.getSeed();
+            }
+            else if (!recordFile.empty())
+            {
+                replay.record(recordFile, seed);
+            }
+            if (!hashLog.empty())
+            {
+                replay.openHashLog(hashLog);
+            }
+
+            //Create player, enemies, etc.
+            Simulation simulation(seed);
+
+            //Workers for the parallel phases of a tick
+            JobSystem jobs(workers);
+            simulation.setJobSystem(&jobs);
+
+            //Pack every sprite sheet into an atlas, so that all sprites can
+            //be drawn in a few batched calls
+            TextureAtlas atlas;
+            simulation.addSheets(atlas);
+            atlas.build();
+            SpriteBatch batch(&atlas);
+
+            //Background, drawn from chunks cached in textures. It does not
+            //follow the camera, it scrolls on its own
+            Tilemap background;
+            background.load( BACKGROUND_MAP );
+            background.setRepeat(true);
+            background.setLayer(BACKGROUND_LAYER);
+
+            //Game loop timing
+            Game game(TICK_RATE, MAX_FPS);
+
+            //Key events, turned into actions for the simulation ticks
+            Input input;
+            if (!bindings.empty())
+            {
+                input.loadBindings(bindings);
+            }
+            input.setLatencyMode(latency);
+
+            //Simulation thread, the main thread only handles events and
+            //draws snapshots published by it
+            Pipeline pipeline(simulation, input, TICK_RATE);
+            if (replay.isActive())
+            {
+                pipeline.setReplay(&replay);
+            }
+            pipeline.setMaxTicks(maxTicks);
+            if (threaded)
+            {
+                pipeline.start();
+            }
+
+            //Frames over budget, and what happened in them
+            HitchDetector hitches(hitchBudget);
+            if (!hitchLog.empty())
+            {
+                hitches.open(hitchLog);
+            }
+
+            //Replay: every recorded tick back to back, nothing drawn
+            if (replay.isReplaying())
+            {
+                Uint64 start = SDL_GetPerformanceCounter();
+                while (!replay.isDone())
+                {
+                    simulation.tick( replay.input( 0 ) );
+                    replay.check( simulation.hash() );
+                }
+                double seconds = (double)(SDL_GetPerformanceCounter() - start)/SDL_GetPerformanceFrequency();
+
+                printf( "Replay: %lu ticks in %.3f s (%.0f ticks/s), final hash %016llx\n",
+                        replay.getTick(), seconds, replay.getTick()/std::max(seconds, 1e-9),
+                        (unsigned long long)replay.getHash() );
+                if (replay.getMismatches() > 0)
+                {
+                    printf( "Replay diverged from the recording at tick %lu, %lu of its hashes differ!\n",
+                            replay.getFirstMismatch(), replay.getMismatches() );
+                    status = 1;
+                }
+
+                quit = true;
             }
-            //Play music
-            Mix_PlayMusic( music, -1 );
-
-
-            //Create player
-            int spriteWidth  = 128;
-            int spriteHeight = 64;
-            unsigned int nSprites = 2;
-            std::string filename = DATADIR "/graphics/ship.png";
-            User player(spriteWidth, spriteHeight, nSprites, filename);
-            
-            //Allocate vector for enemies
-            //Since we are not calling the constructor
-            //This avoids loading sprites and actually wasting memory
-            //Since the number of enemies is not constant
-            std::vector<Enemy> enemies;
-
-            // Initializes RNG
-            std::default_random_engine generator;
-            std::uniform_int_distribution<unsigned> distribution(1,100);
-            
 
             //Game loop
             while(!quit)
             {
+                game.beginFrame();
+                hitches.beginFrame();
+
+                //Entities drawn, collisions and oldest input applied this frame
+                unsigned int entities   = 0;
+                unsigned int collisions = 0;
+                Uint64 inputTime        = 0;
+
                 //Event handling -------------------
 
-                //SDL Event
-                SDL_Event evt;
-                while( SDL_PollEvent( &evt ) != 0 )
                 {
-                    //Closing window
-                    if( evt.type == SDL_QUIT )
+                    PROFILE_ZONE("events");
+
+                    //SDL Event
+                    SDL_Event evt;
+                    while( SDL_PollEvent( &evt ) != 0 )
                     {
-                        quit = true;
+                        //Closing window
+                        if( evt.type == SDL_QUIT )
+                        {
+                            quit = true;
+                        }
+
+                        //Textures used as render targets lost their content
+                        if( evt.type == SDL_RENDER_TARGETS_RESET )
+                        {
+                            background.invalidate();
+                        }
+
+                        //Player actions
+                        input.handleEvent( evt );
+#ifdef ENABLE_PROFILER
+                        //Profiler overlay
+                        if( (evt.type == SDL_KEYDOWN) && (evt.key.keysym.scancode == SDL_SCANCODE_F3) )
+                        {
+                            profiler.toggleOverlay();
+                        }
+#endif
                     }
                 }
 
-                //Key states handling
-                //N.B. we don't use "else if" otherwise we would
-                //only register one key at a time! (i.e. no diagonal movement!)
-                const Uint8* keyStates = SDL_GetKeyboardState( NULL );
+                hitches.lap("events");
 
-                if( keyStates[ SDL_SCANCODE_UP ] )
-                {
-                    player.updatePosY(-5);
-                }
-                if( keyStates[ SDL_SCANCODE_DOWN ])
+                //Simulation ---------------------
+                //Runs at a fixed tick rate, independently of the frame rate.
+                //All speeds are in pixels per tick.
+                if (threaded)
                 {
-                    player.updatePosY(5);
+                    collisions = pipeline.takeCollisions();
+                    if ((maxTicks != 0) && (pipeline.getTicks() >= maxTicks))
+                    {
+                        quit = true;
+                    }
                 }
-                if( keyStates[ SDL_SCANCODE_LEFT ])
+                while( !threaded && game.tick() )
                 {
-                    player.updatePosX(-5);
+                    ActionSet actions = input.update( game.getTickTime() );
+                    if (inputTime == 0)
+                    {
+                        inputTime = input.getAppliedTime();
+                    }
+
+                    if (replay.isActive())
+                    {
+                        actions = replay.input(actions);
+                    }
+                    collisions += simulation.tick(actions);
+                    if (replay.isActive())
+                    {
+                        replay.check( simulation.hash() );
+                    }
+
+                    if ((maxTicks != 0) && (game.getTicks() >= maxTicks))
+                    {
+                        quit = true;
+                        break;
+                    }
                 }
-                if( keyStates[ SDL_SCANCODE_RIGHT ])
+
+                //Hits of this frame would start on the same sample, so one
+                //sound covers them all
+                if (collisions > 0)
                 {
-                    player.updatePosX(5);
+                    audio.play( hitSound );
                 }
-                
-                //Game logic ---------------------
 
-                // Enforce boundary
-                player.enforceBoundary();
+                hitches.lap("simulation");
+
+                //Streaming ----------------------
+                //Upload what was loaded in the background, within a budget
 
-                // Create enemy with a certain probability
-                if (distribution(generator) < 4) 
                 {
-                    enemies.push_back(Enemy(spriteWidth, spriteHeight, nSprites, filename));
+                    PROFILE_ZONE("stream");
 
-                    // randomize position
-                    enemies.back().setPosX(distribution(generator) + 100);
-                    enemies.back().setPosY(distribution(generator) + 100);
-                }
+                    streamer.update();
 
-                // Erase enemies if they leave screen
-                for(int i = 0; i < enemies.size(); i++)
-                {
-                    if (enemies[i].getPosX() < 0)
+                    //Play music
+                    if( !musicStarted && streamer.isReady( music ) )
                     {
-                        enemies.erase (enemies.begin() + i);
+                        audio.playMusic( streamer.getMusic( music ) );
+                        musicStarted = true;
                     }
                 }
-                // Check for collisions
-                for(int i = 0; i < enemies.size(); i++)
+
+                hitches.lap("stream");
+
+                //Drawing ------------------------
+
                 {
-                    if ( spriteCollision(player, enemies[i]) )
+                    PROFILE_ZONE("draw");
+
+                    //Clear screen
+                    SDL_SetRenderDrawColor( renderer, 0, 0, 0, 255 );
+                    SDL_RenderClear( renderer );
+
+                    //Sprites, interpolated from the previous to the last tick
+                    double alpha;
+                    unsigned long ticks;
+                    if (threaded)
+                    {
+                        const StateSnapshot& snapshot = pipeline.acquire();
+                        alpha = pipeline.getAlpha(snapshot);
+                        ticks = snapshot.getTick();
+                        snapshot.draw(batch, alpha);
+                        entities  = snapshot.size();
+                        inputTime = snapshot.getInputTime();
+                    }
+                    else
                     {
-                        std::cout << "Collision!";
+                        alpha = game.getAlpha();
+                        ticks = game.getTicks();
+                        simulation.draw(batch, alpha);
+                        entities = simulation.getEnemies().size() + 1;
                     }
+
+                    //Background, scrolling left with the ticks, interpolated
+                    //like the sprites
+                    double scroll = (std::max(ticks, 1ul) - 1 + alpha)*BACKGROUND_SPEED;
+                    batch.setLayer(BACKGROUND_LAYER, 0, 0, -(int)scroll, 0);
+                    background.draw(batch);
+                    batch.flush();
+#ifdef ENABLE_PROFILER
+                    profiler.drawOverlay();
+#endif
                 }
-                //Update animation
-                player.updateFrame();
 
-                // Update enemies
-                for (int i = 0; i < enemies.size(); i++)
+                hitches.lap("draw");
+
                 {
-                    enemies[i].setPosX(enemies[i].getPosX() + enemies[i].getVX());
-                    enemies[i].updateFrame();
+                    PROFILE_ZONE("present");
+
+                    //Update screen
+                    SDL_RenderPresent( renderer );
                 }
 
-                // Check for collisions
-                //TBD
+                input.presented( inputTime );
 
-                //Drawing ------------------------
+                hitches.lap("present");
+
+                //Frame rate cap
+                game.endFrame();
+
+                hitches.lap("cap");
+                hitches.endFrame(entities, threaded ? pipeline.getTicks() : game.getTicks());
 
-                //Clear screen
-                SDL_SetRenderDrawColor( renderer, 0, 0, 0, 255 );
-                SDL_RenderClear( renderer );
+                PROFILE_FRAME();
+
+            }
 
-                player.draw();
+            pipeline.stop();
 
-                // Draw enemies
-                for(int i = 0; i< enemies.size(); i++)
+            if (replay.isRecording())
+            {
+                unsigned long ticks = replay.getNTicks();
+                if (replay.save())
                 {
-                    enemies[i].draw();
+                    printf( "Recorded %lu ticks to %s\n", ticks, recordFile.c_str() );
                 }
-                
-                //Update screen
-                SDL_RenderPresent( renderer );
+            }
+
+            printf( "Audio: %lu sounds played, %lu voices stolen, %lu dropped\n",
+                    audio.getPlayed(), audio.getStolen(), audio.getDropped() );
+
+            printf( "Input latency: %lu inputs, %.1f ms average, %.1f ms worst\n",
+                    input.getLatencyCount(), input.getLatencyAverage(), input.getLatencyMax() );
 
+            printf( "Background: %lu chunks built, %u cached, %u drawn per frame\n",
+                    background.getNBuilt(), background.getNResident(), background.getNDrawn() );
+
+            printf( "Hitches: %lu of %lu frames over %.1f ms, worst frame %.1f ms\n",
+                    hitches.getHitches(), hitches.getFrames(), hitches.getBudget(), hitches.getWorst() );
+
+            //Asset cache statistics - after the first spawn every enemy
+            //should be a hit, i.e. no disk access
+            printf( "Asset cache: %lu hits, %lu misses, %lu bytes resident\n",
+                    assetCache.getHits(), assetCache.getMisses(),
+                    (unsigned long) assetCache.getBytesResident() );
+
+            //Pool usage - growths stay 0 as long as the capacity suffices
+            printf( "Enemy pool: %u of %u used at most, %lu growths, arena high water %lu bytes\n",
+                    simulation.getEnemies().getHighWater(), simulation.getEnemies().getCapacity(),
+                    simulation.getEnemies().getGrowths(),
+                    (unsigned long) simulation.getArena().getHighWater() );
+
+#ifdef ENABLE_PROFILER
+            if (!profileCsv.empty())
+            {
+                profiler.writeCsv(profileCsv);
+            }
+            if (!profileTrace.empty())
+            {
+                profiler.writeTrace(profileTrace);
             }
+#endif
         }
         catch(...)
         {
@@ -198,9 +535,14 @@ int main(int argvc, char* argv[])
             //int SDL_ShowMessageBox(SDL_MessageBoxData* msgData, int* buttonId);
 
             //Kill program, with exit code -1
+            sdlClose();
             return -1;
         }
 
-        return 0;
+        //Sprites and streamed music are out of scope by now, so everything
+        //can be released
+        sdlClose();
+
+        return status;
     }
 }
@@ -0,0 +1,221 @@
+/**
+ * @file
+ *
+ * @brief Offline compiler for sprite manifests
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <SDL.h>
+
+#include "recordWriter.h"
+#include "spriteManifest.h"
+
+/**
+ * @brief Check the frames of a sprite can be drawn by Sprite and EntityStore
+ * Both expect the frames side by side, all of the same size, starting at
+ * the top-left corner of the sheet.
+ */
+static bool isStrip(const std::vector<ManifestFrame>& frames, Uint32 first, Uint32 n)
+{
+    for (Uint32 k = 0; k < n; k++)
+    {
+        const ManifestFrame& frame = frames[first + k];
+        if ((frame.w != frames[first].w) || (frame.h != frames[first].h) ||
+            (frame.x != (Sint32)k*frames[first].w) || (frame.y != 0))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Sprite manifest compiler
+ *
+ * Usage: engineZManifest INPUT OUTPUT
+ *
+ * Input is a text file, one statement per line, # starts a comment:
+ * @code
+ * sprite <name> <sheet> [mask <image>] [layer <n>]
+ * frame <x> <y> <w> <h> [<ticks>]
+ * @endcode
+ * Frames belong to the sprite above them and last one tick unless given.
+ * Paths are relative to the directory the compiled manifest is installed
+ * to. The output is the binary format read by SpriteManifest.
+ */
+int main(int argvc, char* argv[])
+{
+    if (argvc != 3)
+    {
+        printf( "Usage: %s INPUT OUTPUT\n", argv[0] );
+        return 1;
+    }
+
+    std::ifstream input(argv[1]);
+    if (!input)
+    {
+        printf( "Could not open %s!\n", argv[1] );
+        return 1;
+    }
+
+    StringTable strings;
+    std::vector<ManifestSprite> sprites;
+    std::vector<ManifestFrame> frames;
+
+    std::string line;
+    unsigned int lineNumber = 0;
+    while (std::getline(input, line))
+    {
+        lineNumber++;
+
+        std::size_t comment = line.find('#');
+        if (comment != std::string::npos)
+        {
+            line.erase(comment);
+        }
+
+        std::istringstream tokens(line);
+        std::string keyword;
+        if (!(tokens >> keyword))
+        {
+            continue;
+        }
+
+        bool ok = true;
+        if (keyword == "sprite")
+        {
+            std::string name, sheet;
+            ok = static_cast<bool>(tokens >> name >> sheet);
+
+            ManifestSprite sprite;
+            sprite.name       = strings.add(name);
+            sprite.sheet      = strings.add(sheet);
+            sprite.mask       = sprite.sheet;
+            sprite.layer      = 0;
+            sprite.firstFrame = frames.size();
+            sprite.nFrames    = 0;
+
+            std::string option, value;
+            while (ok && (tokens >> option))
+            {
+                if ((option == "mask") && (tokens >> value))
+                {
+                    sprite.mask = strings.add(value);
+                }
+                else if ((option == "layer") && (tokens >> sprite.layer))
+                {
+                }
+                else
+                {
+                    ok = false;
+                }
+            }
+
+            sprites.push_back(sprite);
+        }
+        else if ((keyword == "frame") && !sprites.empty())
+        {
+            ManifestFrame frame;
+            frame.duration = 1;
+            ok = static_cast<bool>(tokens >> frame.x >> frame.y >> frame.w >> frame.h);
+            if (ok && !(tokens >> frame.duration))
+            {
+                frame.duration = 1;
+            }
+            ok = ok && (frame.w > 0) && (frame.h > 0) && (frame.duration > 0);
+
+            frames.push_back(frame);
+            sprites.back().nFrames++;
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if (!ok)
+        {
+            printf( "%s:%u: syntax error\n", argv[1], lineNumber );
+            return 1;
+        }
+    }
+
+    for (unsigned int i = 0; i < sprites.size(); i++)
+    {
+        const char* name = strings.data.c_str() + sprites[i].name;
+        if (0 == sprites[i].nFrames)
+        {
+            printf( "%s: sprite %s has no frames\n", argv[1], name );
+            return 1;
+        }
+        if (!isStrip(frames, sprites[i].firstFrame, sprites[i].nFrames))
+        {
+            printf( "%s: frames of sprite %s must be equally sized and side by side from (0,0)\n",
+                    argv[1], name );
+            return 1;
+        }
+    }
+
+    ManifestHeader header;
+    header.magic         = MANIFEST_MAGIC;
+    header.version       = MANIFEST_VERSION;
+    header.nSprites      = sprites.size();
+    header.nFrames       = frames.size();
+    header.stringsOffset = sizeof(ManifestHeader) + sprites.size()*sizeof(ManifestSprite)
+                         + frames.size()*sizeof(ManifestFrame);
+    header.stringsSize   = strings.data.size() + 1;
+
+    FILE* output = fopen(argv[2], "wb");
+    if (output == NULL)
+    {
+        printf( "Could not create %s!\n", argv[2] );
+        return 1;
+    }
+
+    // Every record is made of 32 bit words only
+    bool ok = writeWords(output, reinterpret_cast<const Uint32*>(&header), sizeof(header)/4);
+    for (unsigned int i = 0; ok && (i < sprites.size()); i++)
+    {
+        ok = writeWords(output, reinterpret_cast<const Uint32*>(&sprites[i]), sizeof(ManifestSprite)/4);
+    }
+    for (unsigned int i = 0; ok && (i < frames.size()); i++)
+    {
+        ok = writeWords(output, reinterpret_cast<const Uint32*>(&frames[i]), sizeof(ManifestFrame)/4);
+    }
+    ok = ok && (fwrite(strings.data.c_str(), strings.data.size() + 1, 1, output) == 1);
+
+    if ((fclose(output) != 0) || !ok)
+    {
+        printf( "Could not write %s!\n", argv[2] );
+        remove(argv[2]);
+        return 1;
+    }
+
+    return 0;
+}
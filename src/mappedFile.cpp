@@ -0,0 +1,142 @@
+/**
+ * @file
+ *
+ * @brief Defines read only memory mapped files
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mappedFile.h"
+
+#ifdef HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @class A whole file mapped into memory, read only. Compiled assets are
+ * read in place from it, so loading them neither parses nor copies
+ * anything and the OS pages them in as they are touched.
+ *
+ * Where mmap is not available (e.g. Windows builds) the file is read into
+ * memory in one go instead.
+ */
+MappedFile::MappedFile(const std::string& filename)
+    :mData(NULL),
+     mSize(0),
+     mMapped(false)
+{
+    std::size_t slash = filename.find_last_of("/\\");
+    mDirectory = (slash == std::string::npos) ? "." : filename.substr(0, slash);
+
+#ifdef HAVE_MMAP
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+        struct stat info;
+        if ((fstat(fd, &info) == 0) && (info.st_size > 0))
+        {
+            void* data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED)
+            {
+                mData   = static_cast<const unsigned char*>(data);
+                mSize   = info.st_size;
+                mMapped = true;
+            }
+        }
+        close(fd);
+    }
+#endif
+
+    if (mData == NULL)
+    {
+        SDL_RWops* file = SDL_RWFromFile(filename.c_str(), "rb");
+        if (file == NULL)
+        {
+            throw std::runtime_error(" Could not open " + filename + "!");
+        }
+
+        Sint64 size = SDL_RWsize(file);
+        unsigned char* data = (size > 0) ? new unsigned char[size] : NULL;
+        if ((data == NULL) || (SDL_RWread(file, data, size, 1) != 1))
+        {
+            delete[] data;
+            SDL_RWclose(file);
+            throw std::runtime_error(" Could not read " + filename + "!");
+        }
+        SDL_RWclose(file);
+
+        mData = data;
+        mSize = size;
+    }
+}
+
+/**
+ * @brief Destructor - unmaps or frees the file
+ */
+MappedFile::~MappedFile()
+{
+#ifdef HAVE_MMAP
+    if (mMapped)
+    {
+        munmap(const_cast<unsigned char*>(mData), mSize);
+        return;
+    }
+#endif
+    delete[] mData;
+}
+
+/**
+ * @brief Get contents of the file
+ * Memory is read only when mapped, never write to it.
+ */
+const unsigned char* MappedFile::getData() const
+{
+    return mData;
+}
+
+/**
+ * @brief Get size of the file
+ */
+std::size_t MappedFile::getSize() const
+{
+    return mSize;
+}
+
+/**
+ * @brief Check whether the file is memory mapped or was read
+ */
+bool MappedFile::isMapped() const
+{
+    return mMapped;
+}
+
+/**
+ * @brief Get directory of the file
+ * Compiled assets refer to other files relative to it.
+ */
+std::string MappedFile::getDirectory() const
+{
+    return mDirectory;
+}
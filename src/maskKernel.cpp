@@ -0,0 +1,329 @@
+/**
+ * @file
+ *
+ * @brief Defines scalar and SIMD narrow phase kernels
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "maskKernel.h"
+
+//@{
+/*
+    SSE2 is part of x86-64, so it is used whenever the compiler targets it.
+    AVX2 is compiled in with a target attribute and only used if the CPU
+    reports it at runtime.
+ */
+#if defined(__SSE2__)
+#define MASK_KERNEL_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MASK_KERNEL_AVX2
+#include <immintrin.h>
+#endif
+//@}
+
+/**
+ * @brief Get 64 pixels of row y, chunk k
+ * The padding word at the end of every row makes reading p[1] safe.
+ */
+static inline Uint64 loadChunk(const MaskRows& m, int y, int k)
+{
+    const Uint64* p = m.first + y*m.stride + k;
+
+    if (0 == m.shift)
+    {
+        return p[0];
+    }
+
+    return (p[0] >> m.shift) | (p[1] << (64 - m.shift));
+}
+
+/**
+ * @brief Scalar kernel over rows [y0, nRows)
+ * One chunk at a time, returns on the first solid pixel pair.
+ */
+static bool scalarRows(const MaskRows& a, const MaskRows& b, int y0,
+                       int nRows, int nChunks, Uint64 tailMask)
+{
+    for (int y = y0; y < nRows; y++)
+    {
+        for (int k = 0; k < nChunks; k++)
+        {
+            Uint64 bits = loadChunk(a, y, k) & loadChunk(b, y, k);
+            if (k == nChunks - 1)
+            {
+                bits &= tailMask;
+            }
+
+            if (bits != 0)
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Scalar kernel, works everywhere
+ */
+static bool scalarKernel(const MaskRows& a, const MaskRows& b,
+                         int nRows, int nChunks, Uint64 tailMask)
+{
+    return scalarRows(a, b, 0, nRows, nChunks, tailMask);
+}
+
+#ifdef MASK_KERNEL_SSE2
+/**
+ * @brief Get chunk k of rows y and y + 1 in one register
+ * A shift count of 64 yields 0 for SSE2 shifts, so no branch is needed
+ * for aligned rows.
+ */
+static inline __m128i loadChunks2(const MaskRows& m, int y, int k, __m128i lowCount, __m128i highCount)
+{
+    const Uint64* p0 = m.first + y*m.stride + k;
+    const Uint64* p1 = p0 + m.stride;
+
+    __m128i low  = _mm_set_epi64x((long long)p1[0], (long long)p0[0]);
+    __m128i high = _mm_set_epi64x((long long)p1[1], (long long)p0[1]);
+
+    return _mm_or_si128(_mm_srl_epi64(low, lowCount), _mm_sll_epi64(high, highCount));
+}
+
+/**
+ * @brief SSE2 kernel, two rows at a time
+ * Sprites are rarely more than a few chunks wide but always many rows
+ * high, so rows are what is processed in parallel.
+ */
+static bool sse2Kernel(const MaskRows& a, const MaskRows& b,
+                       int nRows, int nChunks, Uint64 tailMask)
+{
+    __m128i lowCountA  = _mm_cvtsi32_si128(a.shift);
+    __m128i highCountA = _mm_cvtsi32_si128(64 - a.shift);
+    __m128i lowCountB  = _mm_cvtsi32_si128(b.shift);
+    __m128i highCountB = _mm_cvtsi32_si128(64 - b.shift);
+    __m128i all        = _mm_set1_epi32(-1);
+    __m128i tail       = _mm_set1_epi64x((long long)tailMask);
+    __m128i zero       = _mm_setzero_si128();
+
+    int y = 0;
+    for (; y + 2 <= nRows; y += 2)
+    {
+        for (int k = 0; k < nChunks; k++)
+        {
+            __m128i bits = _mm_and_si128(loadChunks2(a, y, k, lowCountA, highCountA),
+                                         loadChunks2(b, y, k, lowCountB, highCountB));
+            bits = _mm_and_si128(bits, (k == nChunks - 1) ? tail : all);
+
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(bits, zero)) != 0xFFFF)
+            {
+                return true;
+            }
+        }
+    }
+
+    // Odd row left over
+    return scalarRows(a, b, y, nRows, nChunks, tailMask);
+}
+#endif
+
+#ifdef MASK_KERNEL_AVX2
+/**
+ * @brief Get chunk k of rows y to y + 3 in one register
+ */
+__attribute__((target("avx2")))
+static inline __m256i loadChunks4(const MaskRows& m, int y, int k, __m256i rows,
+                                  __m128i lowCount, __m128i highCount)
+{
+    const long long* p = (const long long*)(m.first + y*m.stride + k);
+
+    __m256i low  = _mm256_i64gather_epi64(p,     rows, 8);
+    __m256i high = _mm256_i64gather_epi64(p + 1, rows, 8);
+
+    return _mm256_or_si256(_mm256_srl_epi64(low, lowCount), _mm256_sll_epi64(high, highCount));
+}
+
+/**
+ * @brief AVX2 kernel, four rows at a time
+ * Rows are gathered with the row stride as index.
+ */
+__attribute__((target("avx2")))
+static bool avx2Kernel(const MaskRows& a, const MaskRows& b,
+                       int nRows, int nChunks, Uint64 tailMask)
+{
+    long long strideA = a.stride;
+    long long strideB = b.stride;
+    __m256i rowsA      = _mm256_set_epi64x(3*strideA, 2*strideA, strideA, 0);
+    __m256i rowsB      = _mm256_set_epi64x(3*strideB, 2*strideB, strideB, 0);
+    __m128i lowCountA  = _mm_cvtsi32_si128(a.shift);
+    __m128i highCountA = _mm_cvtsi32_si128(64 - a.shift);
+    __m128i lowCountB  = _mm_cvtsi32_si128(b.shift);
+    __m128i highCountB = _mm_cvtsi32_si128(64 - b.shift);
+    __m256i all        = _mm256_set1_epi32(-1);
+    __m256i tail       = _mm256_set1_epi64x((long long)tailMask);
+
+    int y = 0;
+    for (; y + 4 <= nRows; y += 4)
+    {
+        for (int k = 0; k < nChunks; k++)
+        {
+            __m256i bits = _mm256_and_si256(loadChunks4(a, y, k, rowsA, lowCountA, highCountA),
+                                            loadChunks4(b, y, k, rowsB, lowCountB, highCountB));
+            bits = _mm256_and_si256(bits, (k == nChunks - 1) ? tail : all);
+
+            if (!_mm256_testz_si256(bits, bits))
+            {
+                return true;
+            }
+        }
+    }
+
+    // Up to three rows left over
+    return scalarRows(a, b, y, nRows, nChunks, tailMask);
+}
+#endif
+
+/**
+ * @brief A kernel and its name
+ */
+struct KernelEntry
+{
+    const char* name;
+    MaskKernel kernel;
+};
+
+/**
+ * @brief Check whether the CPU can run a kernel
+ */
+static bool isSupported(const std::string& name)
+{
+    if (name == "scalar")
+    {
+        return true;
+    }
+#ifdef MASK_KERNEL_SSE2
+    if (name == "sse2")
+    {
+        return true;
+    }
+#endif
+#ifdef MASK_KERNEL_AVX2
+    if (name == "avx2")
+    {
+        return __builtin_cpu_supports("avx2");
+    }
+#endif
+    return false;
+}
+
+/**
+ * @brief Get every kernel compiled in, fastest first
+ */
+static const KernelEntry* getKernels()
+{
+    static const KernelEntry kernels[] =
+    {
+#ifdef MASK_KERNEL_AVX2
+        { "avx2",   avx2Kernel },
+#endif
+#ifdef MASK_KERNEL_SSE2
+        { "sse2",   sse2Kernel },
+#endif
+        { "scalar", scalarKernel },
+        { NULL,     NULL }
+    };
+
+    return kernels;
+}
+
+/**
+ * @brief Get the fastest kernel the CPU supports
+ */
+static const KernelEntry* detectKernel()
+{
+    const KernelEntry* kernels = getKernels();
+    for (int i = 0; kernels[i].name != NULL; i++)
+    {
+        if (isSupported(kernels[i].name))
+        {
+            return &kernels[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Get kernel in use
+ * Picked once, on first use (thread safe).
+ */
+static const KernelEntry*& currentKernel()
+{
+    static const KernelEntry* current = detectKernel();
+
+    return current;
+}
+
+/**
+ * @brief Get kernel in use
+ */
+MaskKernel getMaskKernel()
+{
+    return currentKernel()->kernel;
+}
+
+/**
+ * @brief Get name of the kernel in use
+ */
+const char* getMaskKernelName()
+{
+    return currentKernel()->name;
+}
+
+/**
+ * @brief Use a given kernel, e.g. to compare them
+ * Must not be called while collisions are checked on other threads.
+ * @return False if the kernel is unknown or not supported by the CPU
+ */
+bool selectMaskKernel(const std::string& name)
+{
+    if (!isSupported(name))
+    {
+        return false;
+    }
+
+    const KernelEntry* kernels = getKernels();
+    for (int i = 0; kernels[i].name != NULL; i++)
+    {
+        if (name == kernels[i].name)
+        {
+            currentKernel() = &kernels[i];
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,221 @@
+/**
+ * @file
+ *
+ * @brief Defines the pipeline running the simulation on its own thread
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pipeline.h"
+#include "profiler.h"
+
+//Marks mMiddle as published but not yet acquired
+#define FRESH 4
+
+/**
+ * @class Simulation / render pipeline. The simulation runs on its own
+ * thread at a fixed tick rate and publishes a StateSnapshot after every
+ * tick, while the main thread draws the latest published snapshot. Frame
+ * N can thus be presented while tick N + 1 is being simulated.
+ *
+ * Snapshots are handed over through a triple buffer: the simulation
+ * thread writes the back buffer, the render thread reads the front
+ * buffer, and the middle one is swapped with a single atomic exchange by
+ * either side. Nobody ever waits for the other side. (With only two
+ * buffers, one side would have to wait whenever the other is busy.)
+ *
+ * Input is passed through Input's event queue: the main thread queues
+ * events as it polls them, every tick applies those up to its time.
+ */
+Pipeline::Pipeline(Simulation& simulation, Input& input, unsigned int tickRate)
+    :mSimulation(simulation),
+     mInput(input),
+     mReplay(NULL),
+     mMaxTicks(0)
+{
+    if (0 == tickRate)
+    {
+        tickRate = 1;
+    }
+
+    mTickDt = SDL_GetPerformanceFrequency()/tickRate;
+    mRunning.store(false);
+    mTicks.store(0);
+    mCollisions.store(0);
+
+    mBack   = 0;
+    mMiddle.store(1);
+    mFront  = 2;
+}
+
+// Destructor
+Pipeline::~Pipeline()
+{
+    stop();
+}
+
+/**
+ * @brief Start simulation thread
+ */
+void Pipeline::start()
+{
+    if (mRunning.load())
+    {
+        return;
+    }
+
+    mRunning.store(true);
+    mThread = std::thread(&Pipeline::run, this);
+}
+
+/**
+ * @brief Stop simulation thread and wait for it
+ */
+void Pipeline::stop()
+{
+    mRunning.store(false);
+    if (mThread.joinable())
+    {
+        mThread.join();
+    }
+}
+
+/**
+ * @brief Record ticks, replay them or log their hashes
+ * The replay is used by the simulation thread, so it may only be set
+ * while the thread is stopped.
+ */
+void Pipeline::setReplay(Replay* replay)
+{
+    mReplay = replay;
+}
+
+/**
+ * @brief Stop ticking after a number of ticks
+ * The simulation thread ends itself once getTicks() reaches the limit,
+ * so a run ends on the same tick whatever the frame rate. Only while the
+ * thread is stopped.
+ */
+void Pipeline::setMaxTicks(unsigned long ticks)
+{
+    mMaxTicks = ticks;
+}
+
+/**
+ * @brief Get latest complete snapshot
+ * If nothing new was published since the last call, the same snapshot is
+ * returned again. Stays valid until the next call.
+ */
+const StateSnapshot& Pipeline::acquire()
+{
+    if (mMiddle.load() & FRESH)
+    {
+        mFront = mMiddle.exchange(mFront) & ~FRESH;
+    }
+
+    return mBuffers[mFront];
+}
+
+/**
+ * @brief Get interpolation factor for drawing a snapshot now
+ * The snapshot shows the state at its tick time; drawing interpolates
+ * from the previous tick towards it, i.e. the picture lags one tick.
+ */
+double Pipeline::getAlpha(const StateSnapshot& snapshot) const
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (now <= snapshot.getTime())
+    {
+        return 0;
+    }
+
+    return std::min(1.0, (double)(now - snapshot.getTime())/mTickDt);
+}
+
+/**
+ * @brief Get number of simulation ticks run so far
+ */
+unsigned long Pipeline::getTicks() const
+{
+    return mTicks.load();
+}
+
+/**
+ * @brief Get number of collisions since the last call
+ * The render thread plays their sounds.
+ */
+unsigned int Pipeline::takeCollisions()
+{
+    return mCollisions.exchange(0);
+}
+
+/**
+ * @brief Simulation thread main loop
+ * Ticks are scheduled on fixed deadlines. If the thread falls behind by
+ * more than MAX_FRAME_TIME (e.g. suspended) the schedule is reset rather
+ * than catching up. Ends after mMaxTicks ticks, if set.
+ */
+void Pipeline::run()
+{
+    PROFILE_THREAD("simulation");
+
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 next      = SDL_GetPerformanceCounter();
+
+    while (mRunning.load() && ((0 == mMaxTicks) || (mTicks.load() < mMaxTicks)))
+    {
+        Uint64 now = SDL_GetPerformanceCounter();
+        if (now < next)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds((next - now)*1000000/frequency));
+            continue;
+        }
+        if (now - next > MAX_FRAME_TIME*frequency)
+        {
+            next = now;
+        }
+
+        ActionSet actions = mInput.update(next);
+        if (mReplay != NULL)
+        {
+            actions = mReplay->input(actions);
+        }
+
+        mCollisions += mSimulation.tick(actions);
+
+        if (mReplay != NULL)
+        {
+            mReplay->check(mSimulation.hash());
+        }
+
+        // Publish
+        StateSnapshot& snapshot = mBuffers[mBack];
+        mSimulation.snapshot(snapshot);
+        snapshot.setTime(next);
+        snapshot.setInputTime(mInput.getAppliedTime());
+        snapshot.setTick(mTicks.load() + 1);
+        mBack = mMiddle.exchange(mBack | FRESH) & ~FRESH;
+
+        mTicks++;
+        next += mTickDt;
+    }
+}
@@ -0,0 +1,559 @@
+/**
+ * @file
+ *
+ * @brief Defines a lightweight scoped timer profiler
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "profiler.h"
+
+#include <algorithm>
+
+// The profiler used by PROFILE_ZONE and PROFILE_FRAME
+Profiler profiler;
+
+// Profiler the current thread has a track in, and the track's id
+static thread_local const Profiler* trackProfiler = NULL;
+static thread_local unsigned int trackId = 0;
+
+/**
+ * @brief Built-in 3x5 pixel font, for the overlay
+ * One entry per character ('0'-'9' then 'A'-'Z'), rows top to bottom,
+ * 3 bits per row, most significant bit is the top left pixel.
+ */
+static const Uint16 glyphs[] =
+{
+    0x7B6F /* 0 */,
+    0x2C97 /* 1 */,
+    0x73E7 /* 2 */,
+    0x73CF /* 3 */,
+    0x5BC9 /* 4 */,
+    0x79CF /* 5 */,
+    0x79EF /* 6 */,
+    0x7249 /* 7 */,
+    0x7BEF /* 8 */,
+    0x7BCF /* 9 */,
+    0x2BED /* A */,
+    0x6BAE /* B */,
+    0x3923 /* C */,
+    0x6B6E /* D */,
+    0x79A7 /* E */,
+    0x79A4 /* F */,
+    0x396B /* G */,
+    0x5BED /* H */,
+    0x7497 /* I */,
+    0x126A /* J */,
+    0x5BAD /* K */,
+    0x4927 /* L */,
+    0x5FED /* M */,
+    0x6B6D /* N */,
+    0x2B6A /* O */,
+    0x6BA4 /* P */,
+    0x2B73 /* Q */,
+    0x6BAD /* R */,
+    0x388E /* S */,
+    0x7492 /* T */,
+    0x5B6F /* U */,
+    0x5B6A /* V */,
+    0x5BFD /* W */,
+    0x5AAD /* X */,
+    0x5A92 /* Y */,
+    0x72A7 /* Z */
+};
+
+/**
+ * @class Frame profiler. Code is instrumented with named zones
+ * (PROFILE_ZONE), which may be nested. For each of the last PROFILER_FRAMES
+ * frames the profiler keeps the time spent in every zone and every
+ * individual zone entry, from which averages, percentiles, a CSV file or a
+ * Chrome trace (chrome://tracing) are produced.
+ *
+ * Every thread records its zones in a track of its own, without locking,
+ * which endFrame collects into the frame, so zones of the simulation
+ * thread count towards the frame during which they ended. Traces show one
+ * row per track.
+ */
+Profiler::Profiler()
+{
+    mFrame     = 0;
+    mFrequency = SDL_GetPerformanceFrequency();
+    mOverlay   = false;
+    mOwner     = std::this_thread::get_id();
+    mNZones.store(0);
+    mNTracks.store(0);
+
+    // Reserved, so that readers never see the names or tracks move
+    mNames.reserve(PROFILER_MAX_ZONES);
+    mTracks.reserve(PROFILER_MAX_TRACKS);
+
+    mTime.assign(PROFILER_FRAMES*PROFILER_MAX_ZONES, 0);
+    mEvents.resize(PROFILER_FRAMES);
+}
+
+// Destructor
+Profiler::~Profiler()
+{
+
+}
+
+/**
+ * @brief Get id of a zone, registering it on first use
+ * Zones beyond PROFILER_MAX_ZONES all share the last id. Registration is
+ * serialized; a name is complete before the zone count includes it, so
+ * readers only need the count.
+ */
+unsigned int Profiler::getZone(const char* name)
+{
+    std::lock_guard<std::mutex> guard(mLock);
+
+    for (unsigned int i = 0; i < mNames.size(); i++)
+    {
+        if (mNames[i] == name)
+        {
+            return i;
+        }
+    }
+
+    if (mNames.size() == PROFILER_MAX_ZONES)
+    {
+        return PROFILER_MAX_ZONES - 1;
+    }
+
+    mNames.push_back(name);
+    mNZones.store(mNames.size());
+    return mNames.size() - 1;
+}
+
+/**
+ * @brief Enter a zone
+ * @return Start time, to be passed to end
+ */
+Uint64 Profiler::begin()
+{
+    Track* track = getTrack();
+    if (track == NULL)
+    {
+        return 0;
+    }
+
+    track->depth++;
+    return SDL_GetPerformanceCounter();
+}
+
+/**
+ * @brief Leave a zone
+ * The zone goes to the calling thread's track. If endFrame has not
+ * emptied the track for PROFILER_TRACK_EVENTS zones, it is dropped.
+ */
+void Profiler::end(unsigned int zone, Uint64 start)
+{
+    Track* track = getTrack();
+    if (track == NULL)
+    {
+        return;
+    }
+
+    Uint64 now = SDL_GetPerformanceCounter();
+    track->depth--;
+
+    unsigned long written = track->written.load();
+    if (written - track->read.load() >= PROFILER_TRACK_EVENTS)
+    {
+        return;
+    }
+
+    Event& event = track->events[written % PROFILER_TRACK_EVENTS];
+    event.zone  = zone;
+    event.track = track->id;
+    event.depth = track->depth;
+    event.start = start;
+    event.end   = now;
+
+    // Published, endFrame reads up to here
+    track->written.store(written + 1);
+}
+
+/**
+ * @brief Name the calling thread's track
+ * Tracks are called "main" (the thread which created the profiler) or
+ * "thread N" otherwise.
+ */
+void Profiler::setThreadName(const char* name)
+{
+    Track* track = getTrack();
+    if (track == NULL)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(mLock);
+    track->name = name;
+}
+
+/**
+ * @brief Finish current frame and start a new one
+ * Zones recorded by all threads since the last call are added to the
+ * frame. The oldest frame is overwritten. Memory of the event lists is
+ * reused, so this does not allocate once every slot was used.
+ */
+void Profiler::endFrame()
+{
+    unsigned int slot = mFrame % PROFILER_FRAMES;
+
+    unsigned int nTracks = mNTracks.load();
+    for (unsigned int t = 0; t < nTracks; t++)
+    {
+        Track& track = *mTracks[t];
+        unsigned long written = track.written.load();
+        for (unsigned long i = track.read.load(); i < written; i++)
+        {
+            const Event& event = track.events[i % PROFILER_TRACK_EVENTS];
+            mTime[slot*PROFILER_MAX_ZONES + event.zone] += event.end - event.start;
+            mEvents[slot].push_back(event);
+        }
+
+        // The entries may be overwritten from now on
+        track.read.store(written);
+    }
+
+    mFrame++;
+
+    slot = mFrame % PROFILER_FRAMES;
+    std::fill(mTime.begin() + slot*PROFILER_MAX_ZONES,
+              mTime.begin() + (slot + 1)*PROFILER_MAX_ZONES, 0);
+    mEvents[slot].clear();
+}
+
+/**
+ * @brief Get number of registered zones
+ */
+unsigned int Profiler::getNZones() const
+{
+    return mNZones.load();
+}
+
+/**
+ * @brief Get name of a zone
+ */
+const std::string& Profiler::getName(unsigned int zone) const
+{
+    return mNames[zone];
+}
+
+/**
+ * @brief Get average time per frame (ms) spent in a zone
+ * Over the completed frames kept.
+ */
+double Profiler::getAverage(unsigned int zone) const
+{
+    unsigned int n = getNFrames();
+    if (0 == n)
+    {
+        return 0;
+    }
+
+    Uint64 total = 0;
+    for (unsigned int i = 0; i < n; i++)
+    {
+        total += mTime[getSlot(i)*PROFILER_MAX_ZONES + zone];
+    }
+
+    return 1000.0*total/mFrequency/n;
+}
+
+/**
+ * @brief Get percentile of time per frame (ms) spent in a zone
+ * Nearest rank, over the completed frames kept.
+ */
+double Profiler::getPercentile(unsigned int zone, double percentile) const
+{
+    unsigned int n = getNFrames();
+    if (0 == n)
+    {
+        return 0;
+    }
+
+    std::vector<Uint64> times(n);
+    for (unsigned int i = 0; i < n; i++)
+    {
+        times[i] = mTime[getSlot(i)*PROFILER_MAX_ZONES + zone];
+    }
+
+    unsigned int rank = (unsigned int)(percentile/100.0*(n - 1) + 0.5);
+    rank = std::min(rank, n - 1);
+    std::nth_element(times.begin(), times.begin() + rank, times.end());
+
+    return 1000.0*times[rank]/mFrequency;
+}
+
+/**
+ * @brief Write per frame, per zone times (ms) as CSV
+ * One line per completed frame, oldest first, one column per zone.
+ */
+bool Profiler::writeCsv(const std::string& filename) const
+{
+    FILE* file = fopen(filename.c_str(), "w");
+    if (file == NULL)
+    {
+        printf( "Unable to write %s!\n", filename.c_str() );
+        return false;
+    }
+
+    unsigned int nZones = getNZones();
+    fprintf(file, "frame");
+    for (unsigned int z = 0; z < nZones; z++)
+    {
+        fprintf(file, ",%s", mNames[z].c_str());
+    }
+    fprintf(file, "\n");
+
+    unsigned int n = getNFrames();
+    for (unsigned int i = 0; i < n; i++)
+    {
+        fprintf(file, "%lu", mFrame - n + i);
+        for (unsigned int z = 0; z < nZones; z++)
+        {
+            fprintf(file, ",%.4f", 1000.0*mTime[getSlot(i)*PROFILER_MAX_ZONES + z]/mFrequency);
+        }
+        fprintf(file, "\n");
+    }
+
+    fclose(file);
+    return true;
+}
+
+/**
+ * @brief Write every recorded zone in Chrome's trace event format
+ * The file can be loaded in chrome://tracing or https://ui.perfetto.dev
+ */
+bool Profiler::writeTrace(const std::string& filename) const
+{
+    FILE* file = fopen(filename.c_str(), "w");
+    if (file == NULL)
+    {
+        printf( "Unable to write %s!\n", filename.c_str() );
+        return false;
+    }
+
+    fprintf(file, "[\n");
+
+    bool first = true;
+    {
+        std::lock_guard<std::mutex> guard(mLock);
+        for (unsigned int t = 0; t < mNTracks.load(); t++)
+        {
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                    first ? "" : ",\n", t, mTracks[t]->name.c_str());
+            first = false;
+        }
+    }
+
+    unsigned int n = getNFrames();
+    for (unsigned int i = 0; i < n; i++)
+    {
+        const std::vector<Event>& events = mEvents[getSlot(i)];
+        for (unsigned int e = 0; e < events.size(); e++)
+        {
+            fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%u}",
+                    first ? "" : ",\n", mNames[events[e].zone].c_str(),
+                    1e6*events[e].start/mFrequency,
+                    1e6*(events[e].end - events[e].start)/mFrequency, events[e].track);
+            first = false;
+        }
+    }
+
+    fprintf(file, "\n]\n");
+    fclose(file);
+    return true;
+}
+
+/**
+ * @brief Draw per zone times on screen
+ * One line per zone: average, median, 95th and 99th percentile in ms,
+ * plus a bar for the average (full width = one 60 Hz frame).
+ */
+void Profiler::drawOverlay() const
+{
+    if (!mOverlay)
+    {
+        return;
+    }
+
+    int scale  = 2;
+    int line   = 7*scale;
+    int width  = 380;
+    unsigned int nZones = getNZones();
+    int height = line*(nZones + 1) + 2*scale;
+
+    SDL_SetRenderDrawColor( renderer, 0, 0, 0, 255 );
+    SDL_Rect background = { 0, 0, width, height };
+    SDL_RenderFillRect( renderer, &background );
+
+    SDL_SetRenderDrawColor( renderer, 255, 255, 255, 255 );
+    drawText(scale, scale, scale, "ZONE         AVG   P50   P95   P99");
+
+    for (unsigned int z = 0; z < nZones; z++)
+    {
+        int y = scale + line*(z + 1);
+        double average = getAverage(z);
+
+        SDL_SetRenderDrawColor( renderer, 0, 128, 255, 255 );
+        SDL_Rect bar = { 0, y, (int)(average/(1000.0/60)*width), line - scale };
+        SDL_RenderFillRect( renderer, &bar );
+
+        char text[64];
+        snprintf(text, sizeof(text), "%-10.10s %5.2f %5.2f %5.2f %5.2f", mNames[z].c_str(),
+                 average, getPercentile(z, 50), getPercentile(z, 95), getPercentile(z, 99));
+
+        SDL_SetRenderDrawColor( renderer, 255, 255, 255, 255 );
+        drawText(scale, y, scale, text);
+    }
+}
+
+/**
+ * @brief Toggle overlay
+ */
+void Profiler::toggleOverlay()
+{
+    mOverlay = !mOverlay;
+}
+
+/**
+ * @brief Check whether the overlay is shown
+ */
+bool Profiler::getOverlay() const
+{
+    return mOverlay;
+}
+
+/**
+ * @brief Get track of the calling thread
+ * Created on first use, the calling thread remembers its id afterwards.
+ * @return NULL once PROFILER_MAX_TRACKS threads have tracks
+ */
+Profiler::Track* Profiler::getTrack()
+{
+    if (trackProfiler == this)
+    {
+        return mTracks[trackId].get();
+    }
+
+    std::lock_guard<std::mutex> guard(mLock);
+    if (mTracks.size() == PROFILER_MAX_TRACKS)
+    {
+        return NULL;
+    }
+
+    Track* track = new Track;
+    track->id    = mTracks.size();
+    track->depth = 0;
+    track->written.store(0);
+    track->read.store(0);
+    track->events.resize(PROFILER_TRACK_EVENTS);
+    track->name = (std::this_thread::get_id() == mOwner) ?
+                  std::string("main") : "thread " + std::to_string(track->id);
+    mTracks.push_back(std::unique_ptr<Track>(track));
+    mNTracks.store(mTracks.size());
+
+    trackProfiler = this;
+    trackId       = track->id;
+
+    return track;
+}
+
+/**
+ * @brief Get number of completed frames kept
+ */
+unsigned int Profiler::getNFrames() const
+{
+    return std::min(mFrame, (unsigned long)(PROFILER_FRAMES - 1));
+}
+
+/**
+ * @brief Get ring buffer slot of the n-th oldest completed frame
+ */
+unsigned int Profiler::getSlot(unsigned int n) const
+{
+    return (mFrame - getNFrames() + n) % PROFILER_FRAMES;
+}
+
+/**
+ * @brief Draw text with the built-in font, in the current draw color
+ * Lower case letters are drawn as upper case; '.' and ':' are drawn,
+ * other characters are left blank.
+ */
+void Profiler::drawText(int x, int y, int scale, const std::string& text) const
+{
+    for (unsigned int i = 0; i < text.size(); i++)
+    {
+        char c = text[i];
+        if ((c >= 'a') && (c <= 'z'))
+        {
+            c = c - 'a' + 'A';
+        }
+
+        Uint16 glyph = 0;
+        if ((c >= '0') && (c <= '9'))
+        {
+            glyph = glyphs[c - '0'];
+        }
+        else if ((c >= 'A') && (c <= 'Z'))
+        {
+            glyph = glyphs[10 + c - 'A'];
+        }
+        else if (c == '.')
+        {
+            glyph = 0x0002;
+        }
+        else if (c == ':')
+        {
+            glyph = 0x0410;
+        }
+
+        for (int bit = 0; bit < 15; bit++)
+        {
+            if (glyph & (1 << (14 - bit)))
+            {
+                SDL_Rect pixel = { x + (bit % 3)*scale, y + (bit/3)*scale, scale, scale };
+                SDL_RenderFillRect( renderer, &pixel );
+            }
+        }
+
+        x += 4*scale;
+    }
+}
+
+/**
+ * @class Scoped zone timer, see PROFILE_ZONE
+ */
+ProfileScope::ProfileScope(unsigned int zone)
+{
+    mZone  = zone;
+    mStart = profiler.begin();
+}
+
+// Destructor - leaves zone
+ProfileScope::~ProfileScope()
+{
+    profiler.end(mZone, mStart);
+}
@@ -0,0 +1,65 @@
+/**
+ * @file
+ *
+ * @brief Defines the record writing helpers of the offline tools
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "recordWriter.h"
+
+/**
+ * @brief Add a string to the table
+ * @return Offset of the string in data, the same for equal strings
+ */
+Uint32 StringTable::add(const std::string& s)
+{
+    std::map<std::string, Uint32>::const_iterator it = offsets.find(s);
+    if (it != offsets.end())
+    {
+        return it->second;
+    }
+
+    Uint32 offset = data.size();
+    data += s;
+    data += '\0';
+    offsets[s] = offset;
+
+    return offset;
+}
+
+/**
+ * @brief Write 32 bit integers little-endian
+ */
+bool writeWords(FILE* file, const Uint32* words, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; i++)
+    {
+        Uint32 word = SDL_SwapLE32(words[i]);
+        if (fwrite(&word, sizeof(word), 1, file) != 1)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,389 @@
+/**
+ * @file
+ *
+ * @brief Defines recording and replay of runs, for reproducing them exactly
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "replay.h"
+
+/**
+ * @class Records a run, i.e. its seed and the actions of every tick, and
+ * replays it. The simulation depends on nothing else, so a replay
+ * re-executes the run bit for bit: same spawns, same collisions, same
+ * state after every tick. Replays are the workload for performance
+ * regression runs (see --replay in main).
+ *
+ * Actions are run-length encoded, holding a key for a second costs one
+ * run of 8 bytes. A 64 bit hash of the simulation state (see
+ * Simulation::hash()) is stored every REPLAY_HASH_INTERVAL ticks and
+ * compared when replaying, so a replay diverging from its recording is
+ * noticed, and at which tick. The hash after every tick can also be
+ * written to a text file, to diff any two runs.
+ *
+ * N.B. the random number distributions are implementation defined, so
+ * recordings are only portable between builds with the same standard
+ * library.
+ *
+ * Per tick call input() before and check() after the tick, on the thread
+ * running the simulation.
+ */
+Replay::Replay()
+    :mRecording(false),
+     mReplaying(false),
+     mSeed(0),
+     mRun(0),
+     mRunTick(0),
+     mTick(0),
+     mNTicks(0),
+     mHash(0),
+     mMismatches(0),
+     mFirstMismatch(0),
+     mHashLog(NULL)
+{
+
+}
+
+/**
+ * @brief Destructor - saves the recording, if any
+ */
+Replay::~Replay()
+{
+    save();
+
+    if (mHashLog != NULL)
+    {
+        fclose(mHashLog);
+    }
+}
+
+/**
+ * @brief Start recording a run
+ * The recording is written by save(), or at the latest on destruction.
+ * @param seed Seed the simulation was created with
+ */
+void Replay::record(const std::string& filename, unsigned int seed)
+{
+    mFilename  = filename;
+    mRecording = true;
+    mReplaying = false;
+    mSeed      = seed;
+    mRuns.clear();
+    mHashes.clear();
+    mTick   = 0;
+    mNTicks = 0;
+}
+
+/**
+ * @brief Load a recording to replay
+ * The simulation has to be created with getSeed().
+ */
+void Replay::load(const std::string& filename)
+{
+    MappedFile file(filename);
+
+    if (file.getSize() < sizeof(ReplayHeader))
+    {
+        throw std::runtime_error(" Recording is truncated!");
+    }
+
+    ReplayHeader header = *reinterpret_cast<const ReplayHeader*>(file.getData());
+    if ((SDL_SwapLE32(header.magic) != REPLAY_MAGIC) ||
+        (SDL_SwapLE32(header.version) != REPLAY_VERSION))
+    {
+        throw std::runtime_error(" Not a recording, or an old one!");
+    }
+
+    std::size_t nRuns   = SDL_SwapLE32(header.nRuns);
+    std::size_t nHashes = SDL_SwapLE32(header.nHashes);
+    if ((SDL_SwapLE32(header.hashInterval) != REPLAY_HASH_INTERVAL) ||
+        (file.getSize() != sizeof(ReplayHeader) + nRuns*sizeof(ReplayRun) + nHashes*sizeof(Uint64)))
+    {
+        throw std::runtime_error(" Recording is corrupt!");
+    }
+
+    const ReplayRun* runs = reinterpret_cast<const ReplayRun*>(file.getData() + sizeof(ReplayHeader));
+    mRuns.resize(nRuns);
+    unsigned long nTicks = 0;
+    for (std::size_t r = 0; r < nRuns; r++)
+    {
+        mRuns[r].actions = SDL_SwapLE32(runs[r].actions);
+        mRuns[r].ticks   = SDL_SwapLE32(runs[r].ticks);
+        if (mRuns[r].ticks == 0)
+        {
+            throw std::runtime_error(" Recording is corrupt!");
+        }
+        nTicks += mRuns[r].ticks;
+    }
+    if (nTicks != SDL_SwapLE32(header.nTicks))
+    {
+        throw std::runtime_error(" Recording is corrupt!");
+    }
+
+    const unsigned char* hashes = file.getData() + sizeof(ReplayHeader) + nRuns*sizeof(ReplayRun);
+    mHashes.resize(nHashes);
+    for (std::size_t h = 0; h < nHashes; h++)
+    {
+        Uint64 hash;
+        memcpy(&hash, hashes + h*sizeof(Uint64), sizeof(hash));
+        mHashes[h] = SDL_SwapLE64(hash);
+    }
+
+    mFilename.clear();
+    mRecording     = false;
+    mReplaying     = true;
+    mSeed          = SDL_SwapLE32(header.seed);
+    mRun           = 0;
+    mRunTick       = 0;
+    mTick          = 0;
+    mNTicks        = nTicks;
+    mMismatches    = 0;
+    mFirstMismatch = 0;
+}
+
+/**
+ * @brief Write the state hash after every tick to a text file
+ * One line per tick, the tick number and the hash in hex.
+ * @return false if the file could not be created
+ */
+bool Replay::openHashLog(const std::string& filename)
+{
+    if (mHashLog != NULL)
+    {
+        fclose(mHashLog);
+    }
+
+    mHashLog = fopen(filename.c_str(), "w");
+    if (mHashLog == NULL)
+    {
+        printf( "Could not create hash log %s!\n", filename.c_str() );
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Check whether recording
+ */
+bool Replay::isRecording() const
+{
+    return mRecording;
+}
+
+/**
+ * @brief Check whether replaying
+ */
+bool Replay::isReplaying() const
+{
+    return mReplaying;
+}
+
+/**
+ * @brief Check whether there is anything to do per tick
+ * If not, input() and check() need not be called.
+ */
+bool Replay::isActive() const
+{
+    return mRecording || mReplaying || (mHashLog != NULL);
+}
+
+/**
+ * @brief Check whether every recorded tick was replayed
+ */
+bool Replay::isDone() const
+{
+    return mReplaying && (mTick >= mNTicks);
+}
+
+/**
+ * @brief Get actions of the next tick
+ * @param actions Live actions, recorded if recording
+ * @return Recorded actions if replaying (none past the end), else the
+ * live ones
+ */
+ActionSet Replay::input(ActionSet actions)
+{
+    if (mReplaying)
+    {
+        if (mRun >= mRuns.size())
+        {
+            return 0;
+        }
+
+        actions = mRuns[mRun].actions;
+        if (++mRunTick == mRuns[mRun].ticks)
+        {
+            mRun++;
+            mRunTick = 0;
+        }
+    }
+    else if (mRecording)
+    {
+        if (!mRuns.empty() && (mRuns.back().actions == actions))
+        {
+            mRuns.back().ticks++;
+        }
+        else
+        {
+            ReplayRun run = { actions, 1 };
+            mRuns.push_back(run);
+        }
+        mNTicks++;
+    }
+
+    return actions;
+}
+
+/**
+ * @brief Pass the state hash after the tick
+ * Recorded every REPLAY_HASH_INTERVAL ticks, or compared with the
+ * recording if replaying.
+ */
+void Replay::check(Uint64 hash)
+{
+    mHash = hash;
+    mTick++;
+
+    if (mHashLog != NULL)
+    {
+        fprintf(mHashLog, "%lu %016llx\n", mTick, (unsigned long long)hash);
+    }
+
+    if (mTick % REPLAY_HASH_INTERVAL != 0)
+    {
+        return;
+    }
+
+    std::size_t h = mTick/REPLAY_HASH_INTERVAL - 1;
+    if (mRecording)
+    {
+        mHashes.push_back(hash);
+    }
+    else if (mReplaying && (h < mHashes.size()) && (mHashes[h] != hash))
+    {
+        if (mMismatches++ == 0)
+        {
+            mFirstMismatch = mTick;
+        }
+    }
+}
+
+/**
+ * @brief Write the recording
+ * Does nothing unless recording. Recording stops.
+ * @return false if it could not be written
+ */
+bool Replay::save()
+{
+    if (!mRecording)
+    {
+        return true;
+    }
+    mRecording = false;
+
+    FILE* file = fopen(mFilename.c_str(), "wb");
+    if (file == NULL)
+    {
+        printf( "Could not create recording %s!\n", mFilename.c_str() );
+        return false;
+    }
+
+    ReplayHeader header;
+    header.magic        = SDL_SwapLE32(REPLAY_MAGIC);
+    header.version      = SDL_SwapLE32(REPLAY_VERSION);
+    header.seed         = SDL_SwapLE32(mSeed);
+    header.nTicks       = SDL_SwapLE32(mNTicks);
+    header.nRuns        = SDL_SwapLE32(mRuns.size());
+    header.nHashes      = SDL_SwapLE32(mHashes.size());
+    header.hashInterval = SDL_SwapLE32(REPLAY_HASH_INTERVAL);
+    bool ok = (fwrite(&header, sizeof(header), 1, file) == 1);
+
+    for (std::size_t r = 0; ok && (r < mRuns.size()); r++)
+    {
+        ReplayRun run = { SDL_SwapLE32(mRuns[r].actions), SDL_SwapLE32(mRuns[r].ticks) };
+        ok = (fwrite(&run, sizeof(run), 1, file) == 1);
+    }
+    for (std::size_t h = 0; ok && (h < mHashes.size()); h++)
+    {
+        Uint64 hash = SDL_SwapLE64(mHashes[h]);
+        ok = (fwrite(&hash, sizeof(hash), 1, file) == 1);
+    }
+
+    if ((fclose(file) != 0) || !ok)
+    {
+        printf( "Could not write recording %s!\n", mFilename.c_str() );
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Get seed of the run
+ */
+unsigned int Replay::getSeed() const
+{
+    return mSeed;
+}
+
+/**
+ * @brief Get number of ticks run so far
+ */
+unsigned long Replay::getTick() const
+{
+    return mTick;
+}
+
+/**
+ * @brief Get number of ticks recorded
+ */
+unsigned long Replay::getNTicks() const
+{
+    return mNTicks;
+}
+
+/**
+ * @brief Get number of hashes differing from the recording
+ */
+unsigned long Replay::getMismatches() const
+{
+    return mMismatches;
+}
+
+/**
+ * @brief Get first tick whose hash differed from the recording
+ * @return Tick number counting from 1, 0 if none differed
+ */
+unsigned long Replay::getFirstMismatch() const
+{
+    return mFirstMismatch;
+}
+
+/**
+ * @brief Get last state hash passed
+ */
+Uint64 Replay::getHash() const
+{
+    return mHash;
+}
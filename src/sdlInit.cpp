@@ -26,6 +26,16 @@
  */
 
 #include "sdlInit.h"
+#include "assetCache.h"
+
+//Images and masks baked by engineZBake, see data/Makefile.am
+#define ASSET_PACK DATADIR "/assets.bin"
+
+//Off-screen surface the headless renderer draws to
+static SDL_Surface* headlessTarget = NULL;
+
+//Whether SDL_mixer was opened
+static bool audioOpen = false;
 
 //N.B. This needs to be cleaned up!
 bool sdlInit()
@@ -77,12 +87,19 @@ bool sdlInit()
                 }
                 else
                 {
+                    //Use baked images where there are any, decode the rest
+                    assetCache.loadPack( ASSET_PACK );
+
                      //Initialize SDL_mixer 
-                    if( Mix_OpenAudio( 44100, MIX_DEFAULT_FORMAT, 2, 2048 ) < 0 ) 
+                    if( Mix_OpenAudio( 44100, MIX_DEFAULT_FORMAT, 2, AUDIO_BUFFER ) < 0 ) 
                     { 
                         printf( "SDL_mixer could not initialize! SDL_mixer Error: %s\n", Mix_GetError() ); 
                         success = false; 
                     }
+                    else
+                    {
+                        audioOpen = true;
+                    }
                 }
             }
         }
@@ -90,3 +107,84 @@ bool sdlInit()
 
     return success;
 }
+
+/**
+ * @brief Initializes SDL without a display or audio device
+ * Creates a software renderer drawing to an off-screen surface, so sprites
+ * can be loaded and drawn as usual. There is no window (window stays NULL),
+ * no vsync and no audio. Used for benchmarks and CI runs.
+ */
+bool sdlInitHeadless()
+{
+    //Initialize SDL, no subsystem needed
+    if( SDL_Init( 0 ) < 0 )
+    {
+        printf( "SDL could not initialize! SDL Error: %s\n", SDL_GetError() );
+        return false;
+    }
+
+    //Off-screen ARGB8888 target
+    headlessTarget = SDL_CreateRGBSurface( 0, WINDOW_WIDTH, WINDOW_HEIGHT, 32,
+                                           0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000 );
+    if( headlessTarget == NULL )
+    {
+        printf( "Off-screen surface could not be created! SDL Error: %s\n", SDL_GetError() );
+        return false;
+    }
+
+    renderer = SDL_CreateSoftwareRenderer( headlessTarget );
+    if( renderer == NULL )
+    {
+        printf( "Renderer could not be created! SDL Error: %s\n", SDL_GetError() );
+        return false;
+    }
+
+    //Initialize PNG loading
+    int imgFlags = IMG_INIT_PNG;
+    if( !( IMG_Init( imgFlags ) & imgFlags ) )
+    {
+        printf( "SDL_image could not initialize! SDL_image Error: %s\n", IMG_GetError() );
+        return false;
+    }
+
+    //Use baked images where there are any, decode the rest
+    assetCache.loadPack( ASSET_PACK );
+
+    return true;
+}
+
+/**
+ * @brief Shuts down SDL and releases everything created by sdlInit or
+ * sdlInitHeadless
+ * Cached assets are released first, since textures must be destroyed
+ * before the renderer they belong to. Sprites must be gone by then.
+ */
+void sdlClose()
+{
+    assetCache.clear();
+
+    if( audioOpen )
+    {
+        Mix_CloseAudio();
+        audioOpen = false;
+    }
+    IMG_Quit();
+
+    if( renderer != NULL )
+    {
+        SDL_DestroyRenderer( renderer );
+        renderer = NULL;
+    }
+    if( window != NULL )
+    {
+        SDL_DestroyWindow( window );
+        window = NULL;
+    }
+    if( headlessTarget != NULL )
+    {
+        SDL_FreeSurface( headlessTarget );
+        headlessTarget = NULL;
+    }
+
+    SDL_Quit();
+}
@@ -0,0 +1,563 @@
+/**
+ * @file
+ *
+ * @brief Defines class holding and advancing the game state
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "simulation.h"
+#include "spriteFunctions.h"
+#include "profiler.h"
+
+/**
+ * @brief Compiled sprite manifest, see data/sprites.manifest
+ */
+#define SPRITE_MANIFEST DATADIR "/sprites.bin"
+
+/**
+ * @brief Minimum number of enemies per job
+ * Below this the phases run serially, jobs would cost more than they save.
+ */
+#define JOB_GRAIN 1024
+
+/**
+ * @brief Maximum number of enemies alive at once
+ * The enemy store is allocated once for this many.
+ */
+#define MAX_ENEMIES 65536
+
+/**
+ * @brief Initial size of the per-tick scratch arena in bytes
+ * Room for the broad phase candidates with every enemy slot in use.
+ */
+#define ARENA_SIZE (MAX_ENEMIES*sizeof(unsigned int))
+
+/**
+ * @brief Distance the player moves per tick along each axis
+ */
+#define PLAYER_SPEED 5
+
+/**
+ * @brief Handle of the player in the collision cache
+ * The player is not in the enemy store, this is never an enemy's handle.
+ */
+#define PLAYER_HANDLE (~(EntityHandle)0)
+
+/**
+ * @brief Mix a value into a state hash (64 bit FNV-1a, a word at a time)
+ */
+static inline Uint64 hashMix(Uint64 hash, Uint64 value)
+{
+    hash = (hash ^ value)*0x100000001B3ull;
+    return hash ^ (hash >> 32);
+}
+
+/**
+ * @brief Get box covering a sprite moving from (prevX, prevY) to (x, y)
+ */
+static SDL_Rect getSweptBox(int prevX, int prevY, int x, int y, int width, int height)
+{
+    SDL_Rect box;
+    box.x = std::min(prevX, x);
+    box.y = std::min(prevY, y);
+    box.w = width  + std::abs(x - prevX);
+    box.h = height + std::abs(y - prevY);
+
+    return box;
+}
+
+/**
+ * @brief Get index of a sprite which must be in the manifest
+ */
+static unsigned int findSprite(const SpriteManifest& manifest, const std::string& name)
+{
+    int sprite = manifest.find(name);
+    if (sprite < 0)
+    {
+        throw std::runtime_error(" Sprite " + name + " is missing from the sprite manifest!");
+    }
+
+    return sprite;
+}
+
+/**
+ * @brief Create the player as defined by the manifest
+ */
+static User loadPlayer(const SpriteManifest& manifest)
+{
+    unsigned int sprite = findSprite(manifest, "player");
+    SDL_Rect frame      = manifest.getFrame(sprite, 0);
+
+    User player(frame.w, frame.h, manifest.getNFrames(sprite), manifest.getSheet(sprite));
+    player.setMask(manifest.getMask(sprite));
+    player.setFrameDurations(manifest.getDurations(sprite));
+
+    return player;
+}
+
+/**
+ * @brief Get widest frame of any sprite, used as grid cell size
+ */
+static int getMaxWidth(const SpriteManifest& manifest)
+{
+    int width = 1;
+    for (unsigned int i = 0; i < manifest.size(); i++)
+    {
+        width = std::max(width, manifest.getFrame(i, 0).w);
+    }
+
+    return width;
+}
+
+/**
+ * @class Game state and the rules advancing it one tick at a time. It
+ * knows nothing about timing, windows or audio, so the same code runs in
+ * the game, headless and in the benchmark.
+ */
+Simulation::Simulation(unsigned int seed)
+    :mManifest(SPRITE_MANIFEST),
+     mPlayer(loadPlayer(mManifest)),
+     mGrid(WINDOW_WIDTH, WINDOW_HEIGHT, getMaxWidth(mManifest)),
+     mCandidates(NULL),
+     mNCandidates(0),
+     mGenerator(seed),
+     mDistribution(1, 100),
+     mJobs(NULL),
+     mArena(ARENA_SIZE),
+     mNHits(0),
+     mCacheEnabled(false)
+{
+    //Enemies are kept in a packed store, they all share one
+    //sprite type, so spawning one does not load anything
+    unsigned int enemy = findSprite(mManifest, "enemy");
+    mEnemyType  = mEnemies.addType(mManifest, enemy);
+    mEnemyLayer = mManifest.getLayer(enemy);
+    mPlayerLayer = mManifest.getLayer(findSprite(mManifest, "player"));
+    mEnemies.setCapacity(MAX_ENEMIES);
+}
+
+// Destructor
+Simulation::~Simulation()
+{
+
+}
+
+/**
+ * @brief Run one simulation tick
+ * @return Number of collisions of the player with enemies
+ */
+unsigned int Simulation::tick(ActionSet actions)
+{
+    PROFILE_ZONE("tick");
+
+    savePos();
+    input(actions);
+    spawn();
+    cull();
+
+    return animateAndCollide();
+}
+
+/**
+ * @brief Remember where everything was, for interpolation
+ * This is the first phase of a tick, so it also releases the scratch
+ * memory of the previous tick.
+ */
+void Simulation::savePos()
+{
+    PROFILE_ZONE("savePos");
+
+    mArena.reset();
+    mCandidates  = NULL;
+    mNCandidates = 0;
+    mNHits       = 0;
+
+    mPlayer.savePos();
+    mEnemies.savePos();
+}
+
+/**
+ * @brief Move player according to the actions active
+ * N.B. we don't use "else if" otherwise we would
+ * only register one action at a time! (i.e. no diagonal movement!)
+ */
+void Simulation::input(ActionSet actions)
+{
+    PROFILE_ZONE("input");
+
+    if( actions & ACTION_BIT(ACTION_UP) )
+    {
+        mPlayer.updatePosY(-PLAYER_SPEED);
+    }
+    if( actions & ACTION_BIT(ACTION_DOWN) )
+    {
+        mPlayer.updatePosY(PLAYER_SPEED);
+    }
+    if( actions & ACTION_BIT(ACTION_LEFT) )
+    {
+        mPlayer.updatePosX(-PLAYER_SPEED);
+    }
+    if( actions & ACTION_BIT(ACTION_RIGHT) )
+    {
+        mPlayer.updatePosX(PLAYER_SPEED);
+    }
+
+    // Enforce boundary
+    mPlayer.enforceBoundary();
+}
+
+/**
+ * @brief Create enemy with a certain probability
+ */
+void Simulation::spawn()
+{
+    PROFILE_ZONE("spawn");
+
+    if (mDistribution(mGenerator) < 4)
+    {
+        // randomize position
+        int x = mDistribution(mGenerator) + 100;
+        int y = mDistribution(mGenerator) + 100;
+        mEnemies.spawn(mEnemyType, x, y, -1, 0);
+    }
+}
+
+/**
+ * @brief Create a given number of enemies anywhere on screen
+ */
+void Simulation::spawn(unsigned int n)
+{
+    std::uniform_int_distribution<int> posX(0, WINDOW_WIDTH - 1);
+    std::uniform_int_distribution<int> posY(0, WINDOW_HEIGHT - mManifest.getFrame(findSprite(mManifest, "enemy"), 0).h);
+
+    for (unsigned int i = 0; i < n; i++)
+    {
+        int x = posX(mGenerator);
+        int y = posY(mGenerator);
+        mEnemies.spawn(mEnemyType, x, y, -1, 0);
+    }
+}
+
+/**
+ * @brief Erase enemies if they leave screen
+ */
+void Simulation::cull()
+{
+    PROFILE_ZONE("cull");
+
+    for(unsigned int i = 0; i < mEnemies.size(); i++)
+    {
+        if (mEnemies.getPosX(i) < 0)
+        {
+            mEnemies.kill(i);
+        }
+    }
+    mEnemies.compact();
+}
+
+/**
+ * @brief Check for collisions of the player with enemies
+ * Everything is swept from its previous to its current position, so this
+ * runs after everything moved.
+ * @return Number of collisions
+ */
+unsigned int Simulation::collide()
+{
+    PROFILE_ZONE("collide");
+
+    // Broad phase - only enemies close to the player are tested
+    broadPhase();
+
+    // Narrow phase
+    mCache.beginTick();
+    mNHits = 0;
+    for(unsigned int k = 0; k < mNCandidates; k++)
+    {
+        unsigned int i = mCandidates[k];
+        if (narrowTest(i))
+        {
+            mNHits++;
+        }
+    }
+
+    return mNHits;
+}
+
+/**
+ * @brief Update animation and move enemies
+ */
+void Simulation::animate()
+{
+    PROFILE_ZONE("animate");
+
+    mPlayer.updateFrame();
+    mEnemies.update();
+}
+
+/**
+ * @brief Animate and collide using the job system
+ * Same result as animate followed by collide. With a job system the
+ * phases are jobs chained by dependencies: movement (parallel over
+ * enemies) -> broad phase -> narrow phase (parallel over candidates). The
+ * broad phase stays one job, the grid is filled by appending, and so does
+ * the narrow phase while the collision cache is on, the cache is not
+ * thread safe.
+ * @return Number of collisions
+ */
+unsigned int Simulation::animateAndCollide()
+{
+    // Too few enemies to be worth splitting up
+    if (mJobs == NULL || mEnemies.size() < JOB_GRAIN)
+    {
+        animate();
+        return collide();
+    }
+
+    PROFILE_ZONE("animate+collide");
+
+    std::atomic<unsigned int> nHits(0);
+
+    // Movement
+    mPlayer.updateFrame();
+    JobId move = mJobs->parallelFor(0, mEnemies.size(), JOB_GRAIN,
+                                    [this](unsigned int begin, unsigned int end)
+    {
+        mEnemies.update(begin, end);
+    });
+
+    // Broad phase
+    JobId broad = mJobs->add([this]
+    {
+        broadPhase();
+        mCache.beginTick();
+    }, move);
+
+    // The number of candidates is only known once the broad phase is done
+    mJobs->wait(broad);
+
+    // Narrow phase
+    unsigned int grain = mCacheEnabled ? std::max(1u, mNCandidates) : 16;
+    JobId narrow = mJobs->parallelFor(0, mNCandidates, grain,
+                                      [this, &nHits](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int k = begin; k < end; k++)
+        {
+            unsigned int i = mCandidates[k];
+            if (narrowTest(i))
+            {
+                nHits++;
+            }
+        }
+    }, broad);
+
+    mJobs->wait(narrow);
+    mJobs->reset();
+
+    mNHits = nHits.load();
+
+    return mNHits;
+}
+
+/**
+ * @brief Find enemies which may have touched the player during this tick
+ * Boxes cover everything from the previous to the current position. The
+ * candidates live in the tick's scratch memory, room is made for every
+ * enemy.
+ */
+void Simulation::broadPhase()
+{
+    mGrid.clear();
+    for(unsigned int i = 0; i < mEnemies.size(); i++)
+    {
+        SDL_Rect box = getSweptBox(mEnemies.getPrevPosX(i), mEnemies.getPrevPosY(i),
+                                   mEnemies.getPosX(i), mEnemies.getPosY(i),
+                                   mEnemies.getWidth(i), mEnemies.getHeight(i));
+        mGrid.insert(i, box.x, box.y, box.w, box.h);
+    }
+    mGrid.build();
+
+    SDL_Rect box = getSweptBox(mPlayer.getPrevPosX(), mPlayer.getPrevPosY(),
+                               mPlayer.getPosX(), mPlayer.getPosY(),
+                               mPlayer.getWidth(), mPlayer.getHeight());
+    mCandidates  = mArena.allocate<unsigned int>(mEnemies.size());
+    mNCandidates = mGrid.query(box.x, box.y, box.w, box.h, mCandidates);
+}
+
+/**
+ * @brief Check the player against one enemy, exact per pixel
+ * Swept over the tick, so fast sprites do not pass through each other.
+ */
+bool Simulation::narrowTest(unsigned int i)
+{
+    if (!mCacheEnabled)
+    {
+        return sweptMaskCollision(mPlayer.getMask(), mPlayer.getFrame(),
+                                  mPlayer.getPrevPosX(), mPlayer.getPrevPosY(), mPlayer.getPosX(), mPlayer.getPosY(),
+                                  mEnemies.getMask(i), mEnemies.getFrame(i),
+                                  mEnemies.getPrevPosX(i), mEnemies.getPrevPosY(i), mEnemies.getPosX(i), mEnemies.getPosY(i));
+    }
+
+    CollisionBody player;
+    player.handle    = PLAYER_HANDLE;
+    player.mask      = mPlayer.getMask();
+    player.frame     = mPlayer.getFrame();
+    player.prevX     = mPlayer.getPrevPosX();
+    player.prevY     = mPlayer.getPrevPosY();
+    player.x         = mPlayer.getPosX();
+    player.y         = mPlayer.getPosY();
+    player.maxSpeedX = PLAYER_SPEED;
+    player.maxSpeedY = PLAYER_SPEED;
+
+    CollisionBody enemy;
+    enemy.handle    = mEnemies.getHandle(i);
+    enemy.mask      = mEnemies.getMask(i);
+    enemy.frame     = mEnemies.getFrame(i);
+    enemy.prevX     = mEnemies.getPrevPosX(i);
+    enemy.prevY     = mEnemies.getPrevPosY(i);
+    enemy.x         = mEnemies.getPosX(i);
+    enemy.y         = mEnemies.getPosY(i);
+    enemy.maxSpeedX = mEnemies.getVX(i);
+    enemy.maxSpeedY = mEnemies.getVY(i);
+
+    return mCache.test(player, enemy);
+}
+
+/**
+ * @brief Reuse narrow phase results of earlier ticks (off by default)
+ * Results are identical either way. It pays off once sprites move along
+ * with the player or stop animating; right now every enemy moves and
+ * changes frame every tick, so there is nothing to reuse.
+ */
+void Simulation::setCollisionCache(bool enabled)
+{
+    mCacheEnabled = enabled;
+    mCache.clear();
+}
+
+/**
+ * @brief Get collision cache, e.g. for its counters
+ */
+const CollisionCache& Simulation::getCollisionCache() const
+{
+    return mCache;
+}
+
+/**
+ * @brief Run the parallel phases as jobs
+ * The job system must outlive the simulation or be unset first.
+ */
+void Simulation::setJobSystem(JobSystem* jobs)
+{
+    mJobs = jobs;
+}
+
+/**
+ * @brief Queue everything for drawing, on the layers given by the manifest
+ */
+void Simulation::draw(SpriteBatch& batch, double alpha)
+{
+    PROFILE_ZONE("queue");
+
+    mEnemies.draw(batch, mEnemyLayer, alpha);
+    mPlayer.draw(batch, mPlayerLayer, alpha);
+}
+
+/**
+ * @brief Copy everything needed for drawing into a snapshot
+ * Same layers as draw.
+ */
+void Simulation::snapshot(StateSnapshot& snapshot) const
+{
+    snapshot.clear();
+    mEnemies.snapshot(snapshot, mEnemyLayer);
+    mPlayer.snapshot(snapshot, mPlayerLayer);
+}
+
+/**
+ * @brief Add every sprite sheet in use to an atlas
+ */
+void Simulation::addSheets(TextureAtlas& atlas) const
+{
+    for (unsigned int i = 0; i < mManifest.size(); i++)
+    {
+        atlas.add(mManifest.getSheet(i));
+    }
+}
+
+/**
+ * @brief Get per-tick scratch memory, e.g. for its counters
+ */
+const FrameArena& Simulation::getArena() const
+{
+    return mArena;
+}
+
+/**
+ * @brief Get player
+ */
+const User& Simulation::getPlayer() const
+{
+    return mPlayer;
+}
+
+/**
+ * @brief Get enemies
+ */
+const EntityStore& Simulation::getEnemies() const
+{
+    return mEnemies;
+}
+
+/**
+ * @brief Get hash of the simulation state
+ * Covers everything a later tick depends on and which is visible, so two
+ * runs have the same hash after a tick if and only if (barring
+ * collisions of the hash) they are in the same state. See Replay.
+ *
+ * The random number generator is covered by its next draw, taken from a
+ * copy: the linear congruential engine's output is its whole state.
+ */
+Uint64 Simulation::hash() const
+{
+    Uint64 hash = 0xCBF29CE484222325ull;
+
+    std::default_random_engine generator = mGenerator;
+    hash = hashMix(hash, generator());
+
+    hash = hashMix(hash, (Uint32)mPlayer.getPosX());
+    hash = hashMix(hash, (Uint32)mPlayer.getPosY());
+    hash = hashMix(hash, ((Uint64)mPlayer.getFrameTicks() << 32) | mPlayer.getFrame());
+    hash = hashMix(hash, mNHits);
+
+    hash = hashMix(hash, mEnemies.size());
+    for (unsigned int i = 0; i < mEnemies.size(); i++)
+    {
+        hash = hashMix(hash, mEnemies.getHandle(i));
+        hash = hashMix(hash, ((Uint64)(Uint32)mEnemies.getPosX(i) << 32) | (Uint32)mEnemies.getPosY(i));
+        hash = hashMix(hash, ((Uint64)(Uint32)mEnemies.getVX(i) << 32) | (Uint32)mEnemies.getVY(i));
+        hash = hashMix(hash, ((Uint64)mEnemies.getType(i) << 32) | mEnemies.getFrame(i));
+        hash = hashMix(hash, mEnemies.getFrameTicks(i));
+    }
+
+    return hash;
+}
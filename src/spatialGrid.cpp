@@ -0,0 +1,282 @@
+/**
+ * @file
+ *
+ * @brief Defines a uniform grid for broad phase collision detection
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spatialGrid.h"
+
+/**
+ * @class Uniform grid for broad phase collision detection. Boxes are
+ * inserted every tick and sorted into cells with a counting sort, so a
+ * rebuild is two linear passes and no per-cell allocations. Queries then
+ * only look at the cells a box touches, i.e. their cost depends on how
+ * crowded that part of the screen is, not on the total number of boxes.
+ *
+ * Usage:
+ * @code
+ * grid.clear();
+ * // grid.insert(...) for every entity
+ * grid.build();
+ * grid.query(...) / grid.getPairs(...)
+ * @endcode
+ */
+SpatialGrid::SpatialGrid(int width, int height, int cellSize)
+{
+    if (cellSize <= 0)
+    {
+        cellSize = 1;
+    }
+
+    mCellSize = cellSize;
+    mCols     = std::max(1, (width  + cellSize - 1)/cellSize);
+    mRows     = std::max(1, (height + cellSize - 1)/cellSize);
+    mQuery    = 0;
+
+    mCellStart.assign(mCols*mRows + 1, 0);
+}
+
+// Destructor
+SpatialGrid::~SpatialGrid()
+{
+
+}
+
+/**
+ * @brief Remove all entries
+ * Memory is kept, so rebuilding every tick does not allocate.
+ */
+void SpatialGrid::clear()
+{
+    mId.clear();
+    mX.clear();
+    mY.clear();
+    mW.clear();
+    mH.clear();
+    mCellEntries.clear();
+}
+
+/**
+ * @brief Add an axis aligned box
+ */
+void SpatialGrid::insert(unsigned int id, int x, int y, int w, int h)
+{
+    mId.push_back(id);
+    mX.push_back(x);
+    mY.push_back(y);
+    mW.push_back(w);
+    mH.push_back(h);
+}
+
+/**
+ * @brief Sort entries into cells
+ * A box touching several cells is put into each of them.
+ */
+void SpatialGrid::build()
+{
+    unsigned int nCells = mCols*mRows;
+    unsigned int n      = mId.size();
+
+    // Count entries per cell
+    std::fill(mCellStart.begin(), mCellStart.end(), 0);
+    for (unsigned int i = 0; i < n; i++)
+    {
+        int col_1 = getCol(mX[i]);
+        int col_2 = getCol(mX[i] + mW[i] - 1);
+        int row_1 = getRow(mY[i]);
+        int row_2 = getRow(mY[i] + mH[i] - 1);
+
+        for (int row = row_1; row <= row_2; row++)
+        {
+            for (int col = col_1; col <= col_2; col++)
+            {
+                mCellStart[row*mCols + col + 1]++;
+            }
+        }
+    }
+
+    // Prefix sum, mCellStart[c] is now the first entry of cell c
+    for (unsigned int c = 0; c < nCells; c++)
+    {
+        mCellStart[c + 1] += mCellStart[c];
+    }
+
+    // Fill cells, using mCellStart as insertion cursor. Afterwards
+    // mCellStart[c] points at the start of cell c + 1, so shift back.
+    mCellEntries.resize(mCellStart[nCells]);
+    for (unsigned int i = 0; i < n; i++)
+    {
+        int col_1 = getCol(mX[i]);
+        int col_2 = getCol(mX[i] + mW[i] - 1);
+        int row_1 = getRow(mY[i]);
+        int row_2 = getRow(mY[i] + mH[i] - 1);
+
+        for (int row = row_1; row <= row_2; row++)
+        {
+            for (int col = col_1; col <= col_2; col++)
+            {
+                mCellEntries[mCellStart[row*mCols + col]++] = i;
+            }
+        }
+    }
+    for (unsigned int c = nCells; c > 0; c--)
+    {
+        mCellStart[c] = mCellStart[c - 1];
+    }
+    mCellStart[0] = 0;
+
+    if (mStamp.size() < n)
+    {
+        mStamp.resize(n, 0);
+    }
+}
+
+/**
+ * @brief Get ids of boxes which overlap a given box
+ * The result only contains boxes whose bounding box actually overlaps,
+ * each one once, so there are never more than size() of them. The caller
+ * provides the memory, e.g. scratch memory of the current tick.
+ * @return Number of ids written to candidates
+ */
+unsigned int SpatialGrid::query(int x, int y, int w, int h, unsigned int* candidates)
+{
+    unsigned int n = 0;
+
+    // New query number, every stamp becomes stale
+    mQuery++;
+    if (0 == mQuery)
+    {
+        std::fill(mStamp.begin(), mStamp.end(), 0);
+        mQuery = 1;
+    }
+
+    int col_1 = getCol(x);
+    int col_2 = getCol(x + w - 1);
+    int row_1 = getRow(y);
+    int row_2 = getRow(y + h - 1);
+
+    for (int row = row_1; row <= row_2; row++)
+    {
+        for (int col = col_1; col <= col_2; col++)
+        {
+            unsigned int c = row*mCols + col;
+            for (unsigned int k = mCellStart[c]; k < mCellStart[c + 1]; k++)
+            {
+                unsigned int i = mCellEntries[k];
+                if (mStamp[i] == mQuery)
+                {
+                    continue;
+                }
+                mStamp[i] = mQuery;
+
+                if ((mX[i] < x + w) && (x < mX[i] + mW[i]) &&
+                    (mY[i] < y + h) && (y < mY[i] + mH[i]))
+                {
+                    candidates[n++] = mId[i];
+                }
+            }
+        }
+    }
+
+    return n;
+}
+
+/**
+ * @brief Get pairs of ids whose boxes overlap
+ * Two boxes may share several cells; a pair is only reported by the cell
+ * containing the top left corner of their intersection, so every pair is
+ * reported once. pairs is cleared first.
+ */
+void SpatialGrid::getPairs(std::vector< std::pair<unsigned int, unsigned int> >& pairs) const
+{
+    pairs.clear();
+
+    unsigned int nCells = mCols*mRows;
+    for (unsigned int c = 0; c < nCells; c++)
+    {
+        for (unsigned int k_1 = mCellStart[c]; k_1 < mCellStart[c + 1]; k_1++)
+        {
+            unsigned int i = mCellEntries[k_1];
+            for (unsigned int k_2 = k_1 + 1; k_2 < mCellStart[c + 1]; k_2++)
+            {
+                unsigned int j = mCellEntries[k_2];
+
+                int left = std::max(mX[i], mX[j]);
+                int top  = std::max(mY[i], mY[j]);
+                if ((left >= std::min(mX[i] + mW[i], mX[j] + mW[j])) ||
+                    (top  >= std::min(mY[i] + mH[i], mY[j] + mH[j])))
+                {
+                    continue;
+                }
+
+                if ((unsigned int)(getRow(top)*mCols + getCol(left)) == c)
+                {
+                    pairs.push_back(std::make_pair(mId[i], mId[j]));
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Get number of entries
+ */
+unsigned int SpatialGrid::size() const
+{
+    return mId.size();
+}
+
+/**
+ * @brief Get cell size
+ */
+int SpatialGrid::getCellSize() const
+{
+    return mCellSize;
+}
+
+/**
+ * @brief Get cell column of x coordinate, clamped to the grid
+ */
+int SpatialGrid::getCol(int x) const
+{
+    if (x < 0)
+    {
+        return 0;
+    }
+
+    return std::min(x/mCellSize, mCols - 1);
+}
+
+/**
+ * @brief Get cell row of y coordinate, clamped to the grid
+ */
+int SpatialGrid::getRow(int y) const
+{
+    if (y < 0)
+    {
+        return 0;
+    }
+
+    return std::min(y/mCellSize, mRows - 1);
+}
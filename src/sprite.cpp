@@ -28,12 +28,13 @@
  */
 
 #include "sprite.h"
+#include "assetCache.h"
 
 /**
  * @class Class for sprites. All collidable objects, which are sprites, should
  * be instances of a class derived from this one.
  */
-Sprite::Sprite(int width, int height, int nSprites, std::string filename)
+Sprite::Sprite(int width, int height, int nSprites, const std::string& filename)
 {
     // Initialization
     mWidth    = width;
@@ -43,9 +44,12 @@ Sprite::Sprite(int width, int height, int nSprites, std::string filename)
     // Default values
     mPosX  = 0;
     mPosY  = 0;
+    mPrevPosX = 0;
+    mPrevPosY = 0;
     mVX    = 0;
     mVY    = 0;
     mFrame = 1;
+    mFrameTicks = 1;
 
     // Load sprite sheet
     mSprtSheet = loadSpriteSheet(filename);
@@ -54,12 +58,28 @@ Sprite::Sprite(int width, int height, int nSprites, std::string filename)
     mMask = loadMask(filename);
 }
 
-// Destructor
+// Copy constructor
+Sprite::Sprite(const Sprite& other) = default;
+
+// Move constructor
+Sprite::Sprite(Sprite&& other) noexcept = default;
+
+/**
+ * @brief Destructor
+ * The sprite sheet and mask are shared handles, they are released once
+ * the last sprite using them (and the asset cache) lets go of them.
+ */
 Sprite::~Sprite()
 {
 
 }
 
+// Copy assignment
+Sprite& Sprite::operator=(const Sprite& other) = default;
+
+// Move assignment
+Sprite& Sprite::operator=(Sprite&& other) noexcept = default;
+
 /**
  * @brief Get sprite position
  */
@@ -87,6 +107,38 @@ int Sprite::getPosY() const
     return mPosY;
 }
 
+/**
+ * @brief Get X position in the previous tick
+ */
+int Sprite::getPrevPosX() const
+{
+    return mPrevPosX;
+}
+
+/**
+ * @brief Get Y position in the previous tick
+ */
+int Sprite::getPrevPosY() const
+{
+    return mPrevPosY;
+}
+
+/**
+ * @brief Get sprite width
+ */
+int Sprite::getWidth() const
+{
+    return mWidth;
+}
+
+/**
+ * @brief Get sprite height
+ */
+int Sprite::getHeight() const
+{
+    return mHeight;
+}
+
 /**
  * @brief Get sprite speed
  */
@@ -118,27 +170,35 @@ int Sprite::getVY() const
 
 /**
  * @brief Set sprite position
+ * This is a jump, i.e. no interpolation from the previous position.
+ * Use updatePos* for movement.
  */
 void Sprite::setPos(int x, int y)
 {
    mPosX = x;
    mPosY = y;
+   mPrevPosX = x;
+   mPrevPosY = y;
 }
 
 /**
  * @brief Set sprite position in the x direction
+ * This is a jump, i.e. no interpolation from the previous position.
  */
 void Sprite::setPosX(int x)
 {
    mPosX = x;
+   mPrevPosX = x;
 }
 
 /**
  * @brief Set sprite position in the y direction
+ * This is a jump, i.e. no interpolation from the previous position.
  */
 void Sprite::setPosY(int y)
 {
    mPosY = y;
+   mPrevPosY = y;
 }
 
 /**
@@ -194,32 +254,42 @@ void Sprite::updatePos()
 }
 
 /**
- * @brief Draw sprite to screen
+ * @brief Remember current position as the previous tick's position
+ * Should be called at the start of every simulation tick, before moving.
  */
-void Sprite::draw()
+void Sprite::savePos()
 {
-    // Draw sprite from sprite sheet corresponding to the current fram to the screen 
-    // at the current sprite position
+    mPrevPosX = mPosX;
+    mPrevPosY = mPosY;
+}
 
+/**
+ * @brief Queue sprite in a sprite batch, interpolated between ticks
+ * Lower layers are drawn first.
+ */
+void Sprite::draw(SpriteBatch& batch, int layer, double alpha)
+{
     //Clipping - grabbing the correct sprite from sheet
-    SDL_Rect spriteLimits;
-    spriteLimits.x = mWidth*mFrame;
-    spriteLimits.y = 0;
-    spriteLimits.w = mWidth*(mFrame+1);
-    spriteLimits.h = mHeight;
+    SDL_Rect spriteLimits = { (int)(mWidth*mFrame), 0, mWidth, mHeight };
 
     //Render sprite to the right position
+    SDL_Rect renderQuad;
+    renderQuad.x = mPrevPosX + (int)((mPosX - mPrevPosX)*alpha);
+    renderQuad.y = mPrevPosY + (int)((mPosY - mPrevPosY)*alpha);
+    renderQuad.w = mWidth;
+    renderQuad.h = mHeight;
 
-    // The rectangle where we'll render to
-    SDL_Rect renderQuad = { mPosX, mPosY, mPosX+mWidth, mPosY + mHeight }; 
-
-    // Set clip rendering dimensions 
-    renderQuad.w = mWidth; 
-    renderQuad.h = mHeight; 
+    batch.draw(mSprtSheet.get(), spriteLimits, renderQuad, layer);
+}
 
+/**
+ * @brief Add sprite, with its previous and current position, to a snapshot
+ */
+void Sprite::snapshot(StateSnapshot& snapshot, int layer) const
+{
+    SDL_Rect spriteLimits = { (int)(mWidth*mFrame), 0, mWidth, mHeight };
 
-    // Render to screen 
-    SDL_RenderCopy( renderer, mSprtSheet, &spriteLimits, &renderQuad );
+    snapshot.add(mSprtSheet.get(), spriteLimits, mPrevPosX, mPrevPosY, mPosX, mPosY, layer);
 }
 
 /**
@@ -244,6 +314,12 @@ void Sprite::updateFrame(unsigned int frame)
  */
 void Sprite::updateFrame()
 {
+    // Stay on the current frame for as long as it lasts
+    if (!mDurations.empty() && (--mFrameTicks > 0))
+    {
+        return;
+    }
+
     int frame = mFrame + 1;
     // Throw exception whenever nSprites = 0
     if (0 == mNSprites)
@@ -255,6 +331,35 @@ void Sprite::updateFrame()
         // Use modular arithmetic, so it wraps around
         mFrame =  frame % mNSprites;
     }
+
+    if (!mDurations.empty())
+    {
+        mFrameTicks = mDurations[mFrame % mDurations.size()];
+    }
+}
+
+/**
+ * @brief Use a different image for the collision mask
+ * It must have the same layout of frames as the sprite sheet.
+ */
+void Sprite::setMask(const std::string& filename)
+{
+    mMask = loadMask(filename);
+}
+
+/**
+ * @brief Set number of ticks each animation frame is shown
+ * An empty list goes back to one frame per tick.
+ */
+void Sprite::setFrameDurations(const std::vector<unsigned int>& durations)
+{
+    mDurations = durations;
+    for (unsigned int k = 0; k < mDurations.size(); k++)
+    {
+        mDurations[k] = std::max(1u, mDurations[k]);
+    }
+
+    mFrameTicks = mDurations.empty() ? 1 : mDurations[mFrame % mDurations.size()];
 }
 
 /**
@@ -283,33 +388,12 @@ void Sprite::enforceBoundary()
 
 /**
  * @brief Load sprite sheet
+ * The texture is shared with every other sprite using the same file, so
+ * only the first sprite actually loads it from disk.
  */
-SDL_Texture* Sprite::loadSpriteSheet(std::string filename)
+std::shared_ptr<SDL_Texture> Sprite::loadSpriteSheet(const std::string& filename)
 {
-	 //Texture
-	SDL_Texture* texture = NULL; 
-
-	//First we load surface
-	SDL_Surface* surface = IMG_Load( filename.c_str() ); 
-	if( surface == NULL ) 
-	{ 
-		printf( "Unable to load image %s! SDL_image Error: %s\n", filename.c_str(), IMG_GetError() ); 
-	} 
-	else 
-	{ 
-		//Set color key (for transparency)
-		SDL_SetColorKey( surface, SDL_TRUE, SDL_MapRGB( surface->format, COLOR_KEY[0], 
-			             COLOR_KEY[1], COLOR_KEY[2] ) );
-		//Create texture from surface
-		texture = SDL_CreateTextureFromSurface( renderer, surface ); 
-		if( texture == NULL ) { 
-			printf( "Unable to create texture from %s! SDL Error: %s\n", filename.c_str(), SDL_GetError() );
-		} 
-		//Get rid of old loaded surface 
-		SDL_FreeSurface( surface ); 
-	} 
-
-	return texture;
+    return assetCache.getTexture(filename);
 }
 
 /**
@@ -320,29 +404,34 @@ SDL_Texture* Sprite::loadSpriteSheet(std::string filename)
  *
  * @tbd Make bounding box size overridable
  */
-SDL_Surface* Sprite::loadMask(std::string filename)
-{
-	SDL_Surface* surface = IMG_Load( filename.c_str() ); 
-	if( surface == NULL ) 
-	{ 
-		printf( "Unable to load image %s! SDL_image Error: %s\n", filename.c_str(), IMG_GetError() ); 
-	} 
-	else 
-	{ 
-		//Set color key (for transparency)
-		SDL_SetColorKey( surface, SDL_TRUE, SDL_MapRGB( surface->format, COLOR_KEY[0], 
-			             COLOR_KEY[1], COLOR_KEY[2] ) );
-    }
-    return surface;
+std::shared_ptr<BitMask> Sprite::loadMask(const std::string& filename)
+{
+    return assetCache.getMask(filename, mWidth, mHeight);
 }
 
 /**
  * @brief Gets mask
- * Returns a pointer to an SDL_Surface struct
+ * Returns a pointer to the collision mask of the sprite sheet
  *
  */
-SDL_Surface* Sprite::getMask() const
+const BitMask* Sprite::getMask() const
+{
+    return mMask.get();
+}
+
+/**
+ * @brief Get current animation frame
+ */
+unsigned int Sprite::getFrame() const
+{
+    return mFrame;
+}
+
+/**
+ * @brief Get ticks left until the next animation frame
+ */
+unsigned int Sprite::getFrameTicks() const
 {
-    return mMask;
+    return mFrameTicks;
 }
 
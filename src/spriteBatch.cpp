@@ -0,0 +1,372 @@
+/**
+ * @file
+ *
+ * @brief Defines a batch collecting sprite draws and submitting them in few calls
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spriteBatch.h"
+
+/**
+ * @class Sprite batch. Sprites are queued during the frame instead of being
+ * drawn right away. On flush they are sorted by layer and texture and every
+ * run of sprites sharing a texture is submitted as a single
+ * SDL_RenderGeometry call. Together with a TextureAtlas this turns
+ * N sprites into a handful of draw calls.
+ *
+ * With SDL older than 2.0.18 (no SDL_RenderGeometry) sprites are still
+ * sorted, but drawn one SDL_RenderCopy at a time.
+ *
+ * Sprites are queued in world coordinates. Each layer is moved onto the
+ * screen by the camera, scaled by the layer's parallax factor (distant
+ * backgrounds scroll slower, a HUD not at all), plus the layer's offset.
+ * Sprites which end up outside the viewport are culled when queued, so a
+ * large scrolling level only costs render calls for what is visible.
+ * By default the camera is at (0, 0) and the viewport is the window,
+ * i.e. world and screen coordinates are the same.
+ */
+SpriteBatch::SpriteBatch(const TextureAtlas* atlas)
+{
+    mAtlas      = atlas;
+    mNSprites   = 0;
+    mNDrawCalls = 0;
+
+    mCameraX        = 0;
+    mCameraY        = 0;
+    mViewport.x     = 0;
+    mViewport.y     = 0;
+    mViewport.w     = WINDOW_WIDTH;
+    mViewport.h     = WINDOW_HEIGHT;
+    mClipToViewport = false;
+    mShiftLayer     = 0;
+    mShiftValid     = false;
+    mCulled         = 0;
+    mNCulled        = 0;
+}
+
+// Destructor
+SpriteBatch::~SpriteBatch()
+{
+
+}
+
+/**
+ * @brief Queue a sprite
+ */
+void SpriteBatch::draw(SDL_Texture* texture, const SDL_Rect& clip, const SDL_Rect& dst, int layer)
+{
+    if (texture == NULL)
+    {
+        return;
+    }
+
+    // Cull before anything else is done with the sprite
+    const std::pair<int, int>& shift = getShift(layer);
+    SDL_Rect screen = { dst.x + shift.first, dst.y + shift.second, dst.w, dst.h };
+    if ((screen.x >= mViewport.x + mViewport.w) || (screen.x + screen.w <= mViewport.x) ||
+        (screen.y >= mViewport.y + mViewport.h) || (screen.y + screen.h <= mViewport.y))
+    {
+        mCulled++;
+        return;
+    }
+
+    SDL_Rect atlasClip = clip;
+    if (mAtlas != NULL)
+    {
+        texture = mAtlas->lookup(texture, atlasClip);
+    }
+
+    mTexture.push_back(texture);
+    mClip.push_back(atlasClip);
+    mDst.push_back(screen);
+    mLayer.push_back(layer);
+}
+
+namespace
+{
+    // Orders queued sprites by layer, then texture
+    struct BatchOrder
+    {
+        const std::vector<int>* layer;
+        const std::vector<SDL_Texture*>* texture;
+
+        bool operator()(unsigned int a, unsigned int b) const
+        {
+            if ((*layer)[a] != (*layer)[b])
+            {
+                return (*layer)[a] < (*layer)[b];
+            }
+            return std::less<SDL_Texture*>()((*texture)[a], (*texture)[b]);
+        }
+    };
+}
+
+/**
+ * @brief Draw everything queued and empty the queue
+ * Sorting is stable, so sprites of the same layer and texture are drawn in
+ * the order they were queued.
+ */
+void SpriteBatch::flush()
+{
+    unsigned int n = mTexture.size();
+
+    mOrder.resize(n);
+    for (unsigned int i = 0; i < n; i++)
+    {
+        mOrder[i] = i;
+    }
+
+    BatchOrder order;
+    order.layer   = &mLayer;
+    order.texture = &mTexture;
+    std::stable_sort(mOrder.begin(), mOrder.end(), order);
+
+    mNSprites   = n;
+    mNDrawCalls = 0;
+    mNCulled    = mCulled;
+    mCulled     = 0;
+
+    // Sprites partly outside a viewport smaller than the window are cut
+    if (mClipToViewport)
+    {
+        SDL_RenderSetClipRect(renderer, &mViewport);
+    }
+
+    unsigned int begin = 0;
+    while (begin < n)
+    {
+        unsigned int end = begin + 1;
+        while ((end < n) && (mTexture[mOrder[end]] == mTexture[mOrder[begin]]))
+        {
+            end++;
+        }
+
+        drawRun(begin, end);
+        begin = end;
+    }
+
+    if (mClipToViewport)
+    {
+        SDL_RenderSetClipRect(renderer, NULL);
+    }
+
+    mTexture.clear();
+    mClip.clear();
+    mDst.clear();
+    mLayer.clear();
+}
+
+/**
+ * @brief Set world position shown at the top left corner of the viewport
+ */
+void SpriteBatch::setCamera(int x, int y)
+{
+    mCameraX    = x;
+    mCameraY    = y;
+    mShiftValid = false;
+}
+
+/**
+ * @brief Get world position shown at the top left corner of the viewport
+ */
+std::pair<int, int> SpriteBatch::getCamera() const
+{
+    return std::make_pair(mCameraX, mCameraY);
+}
+
+/**
+ * @brief Set part of the screen drawn to
+ * Sprites outside are culled, and sprites partly outside are cut unless
+ * the viewport is the whole window.
+ */
+void SpriteBatch::setViewport(const SDL_Rect& viewport)
+{
+    mViewport       = viewport;
+    mClipToViewport = (viewport.x != 0) || (viewport.y != 0) ||
+                      (viewport.w != WINDOW_WIDTH) || (viewport.h != WINDOW_HEIGHT);
+    mShiftValid     = false;
+}
+
+/**
+ * @brief Get part of the screen drawn to
+ */
+const SDL_Rect& SpriteBatch::getViewport() const
+{
+    return mViewport;
+}
+
+/**
+ * @brief Set how a layer follows the camera
+ * Layers not set follow it exactly (parallax 1, no offset).
+ * @param parallaxX Horizontal scroll per pixel of camera movement
+ * @param parallaxY Vertical scroll per pixel of camera movement
+ * @param offsetX Horizontal screen offset of the layer
+ * @param offsetY Vertical screen offset of the layer
+ */
+void SpriteBatch::setLayer(int layer, float parallaxX, float parallaxY, int offsetX, int offsetY)
+{
+    Layer& settings = mLayers[layer];
+    settings.parallaxX = parallaxX;
+    settings.parallaxY = parallaxY;
+    settings.offsetX   = offsetX;
+    settings.offsetY   = offsetY;
+    mShiftValid = false;
+}
+
+/**
+ * @brief Check whether a sprite at dst would be visible
+ * @param dst Where the sprite is, in world coordinates
+ */
+bool SpriteBatch::isVisible(const SDL_Rect& dst, int layer)
+{
+    const std::pair<int, int>& shift = getShift(layer);
+    int x = dst.x + shift.first;
+    int y = dst.y + shift.second;
+
+    return (x < mViewport.x + mViewport.w) && (x + dst.w > mViewport.x) &&
+           (y < mViewport.y + mViewport.h) && (y + dst.h > mViewport.y);
+}
+
+/**
+ * @brief Get part of the world a layer shows in the viewport
+ * Anything of the layer outside this rectangle is culled.
+ */
+SDL_Rect SpriteBatch::getView(int layer)
+{
+    const std::pair<int, int>& shift = getShift(layer);
+    SDL_Rect view = { mViewport.x - shift.first, mViewport.y - shift.second, mViewport.w, mViewport.h };
+
+    return view;
+}
+
+/**
+ * @brief Get number of sprites drawn by the last flush
+ */
+unsigned int SpriteBatch::getNSprites() const
+{
+    return mNSprites;
+}
+
+/**
+ * @brief Get number of render calls issued by the last flush
+ */
+unsigned int SpriteBatch::getNDrawCalls() const
+{
+    return mNDrawCalls;
+}
+
+/**
+ * @brief Get number of sprites culled, i.e. queued but not drawn, by the last flush
+ */
+unsigned int SpriteBatch::getNCulled() const
+{
+    return mNCulled;
+}
+
+/**
+ * @brief Get world to screen translation of a layer
+ * Sprites come in runs of the same layer, so the last one is remembered.
+ */
+const std::pair<int, int>& SpriteBatch::getShift(int layer)
+{
+    if (mShiftValid && (layer == mShiftLayer))
+    {
+        return mShift;
+    }
+
+    float parallaxX = 1, parallaxY = 1;
+    int offsetX = 0, offsetY = 0;
+    std::map<int, Layer>::const_iterator it = mLayers.find(layer);
+    if (it != mLayers.end())
+    {
+        parallaxX = it->second.parallaxX;
+        parallaxY = it->second.parallaxY;
+        offsetX   = it->second.offsetX;
+        offsetY   = it->second.offsetY;
+    }
+
+    mShift.first  = mViewport.x + offsetX - (int)std::floor(mCameraX*parallaxX);
+    mShift.second = mViewport.y + offsetY - (int)std::floor(mCameraY*parallaxY);
+    mShiftLayer   = layer;
+    mShiftValid   = true;
+
+    return mShift;
+}
+
+/**
+ * @brief Draw sprites mOrder[begin] ... mOrder[end - 1], which share a texture
+ */
+void SpriteBatch::drawRun(unsigned int begin, unsigned int end)
+{
+    SDL_Texture* texture = mTexture[mOrder[begin]];
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    int texW, texH;
+    if (SDL_QueryTexture(texture, NULL, NULL, &texW, &texH) != 0)
+    {
+        return;
+    }
+
+    // Two triangles per sprite
+    mVertices.resize(4*(end - begin));
+    mIndices.resize(6*(end - begin));
+
+    SDL_Color white = { 255, 255, 255, 255 };
+    for (unsigned int k = begin; k < end; k++)
+    {
+        const SDL_Rect& clip = mClip[mOrder[k]];
+        const SDL_Rect& dst  = mDst[mOrder[k]];
+
+        float u_1 = (float)clip.x/texW;
+        float v_1 = (float)clip.y/texH;
+        float u_2 = (float)(clip.x + clip.w)/texW;
+        float v_2 = (float)(clip.y + clip.h)/texH;
+
+        SDL_Vertex* v = &mVertices[4*(k - begin)];
+        v[0].position.x = dst.x;         v[0].position.y = dst.y;
+        v[1].position.x = dst.x + dst.w; v[1].position.y = dst.y;
+        v[2].position.x = dst.x + dst.w; v[2].position.y = dst.y + dst.h;
+        v[3].position.x = dst.x;         v[3].position.y = dst.y + dst.h;
+        v[0].tex_coord.x = u_1; v[0].tex_coord.y = v_1;
+        v[1].tex_coord.x = u_2; v[1].tex_coord.y = v_1;
+        v[2].tex_coord.x = u_2; v[2].tex_coord.y = v_2;
+        v[3].tex_coord.x = u_1; v[3].tex_coord.y = v_2;
+        v[0].color = v[1].color = v[2].color = v[3].color = white;
+
+        int base = 4*(k - begin);
+        int* idx = &mIndices[6*(k - begin)];
+        idx[0] = base;     idx[1] = base + 1; idx[2] = base + 2;
+        idx[3] = base;     idx[4] = base + 2; idx[5] = base + 3;
+    }
+
+    SDL_RenderGeometry(renderer, texture, mVertices.data(), mVertices.size(),
+                       mIndices.data(), mIndices.size());
+    mNDrawCalls++;
+#else
+    for (unsigned int k = begin; k < end; k++)
+    {
+        SDL_RenderCopy(renderer, texture, &mClip[mOrder[k]], &mDst[mOrder[k]]);
+        mNDrawCalls++;
+    }
+#endif
+}
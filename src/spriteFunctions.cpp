@@ -27,6 +27,7 @@
  */
 
 #include "spriteFunctions.h"
+#include "maskKernel.h"
 
 /**
  * @brief Check two sprites for collisions
@@ -34,110 +35,210 @@
  * @note Could be implemented as a method of the sprite class, sort of check for collisions
  * against _this_ sprite.
  */
-bool spriteCollision(Sprite sprite_1, Sprite sprite_2)
+bool spriteCollision(const Sprite& sprite_1, const Sprite& sprite_2)
 {
-    // Get Mask
-    SDL_Surface* mask1 = sprite_1.getMask();
-    SDL_Surface* mask2 = sprite_2.getMask();
-
-    // Get all the needed data
-    //   Bounding box size
-    int sizeH_1 = mask1->h;
-    int sizeW_1 = mask1->w;
-    int sizeH_2 = mask2->h;
-    int sizeW_2 = mask2->w;
-
-    //  Position
-    int posX_1 = sprite_1.getPosX();
-    int posY_1 = sprite_1.getPosY();
-    int posX_2 = sprite_2.getPosX();
-    int posY_2 = sprite_2.getPosY();
-    
-    //   For ease of implementation, calculate length of rectangle edges
-    //   Some of these assignments are useless but it makes the implementation
-    //   cleaner
+    return maskCollision(sprite_1.getMask(), sprite_1.getFrame(), sprite_1.getPosX(), sprite_1.getPosY(),
+                         sprite_2.getMask(), sprite_2.getFrame(), sprite_2.getPosX(), sprite_2.getPosY());
+}
+
+/**
+ * @brief Check two masks, placed at the given positions, for collisions
+ *
+ * First the bounding boxes (one frame each) are checked. If they overlap,
+ * the mask rows of the current frames are ANDed over the overlapping
+ * rectangle, 64 pixels (SIMD: several rows of 64 pixels) at a time,
+ * stopping at the first hit. This is exact per pixel.
+ *
+ * Used for entities which are not Sprite instances (see EntityStore).
+ */
+bool maskCollision(const BitMask* mask1, unsigned int frame_1, int posX_1, int posY_1,
+                   const BitMask* mask2, unsigned int frame_2, int posX_2, int posY_2)
+{
+    if ((mask1 == NULL) || (mask2 == NULL) ||
+        (0 == mask1->getNFrames()) || (0 == mask2->getNFrames()))
+    {
+        return false;
+    }
+
+    //   For ease of implementation, calculate rectangle edges
     int edgeLeft_1   = posX_1;
     int edgeTop_1    = posY_1;
-    int edgeBottom_1 = posY_1 + sizeH_1;
-    int edgeRight_1  = posX_1 + sizeW_1;
+    int edgeBottom_1 = posY_1 + mask1->getHeight();
+    int edgeRight_1  = posX_1 + mask1->getWidth();
     int edgeLeft_2   = posX_2;
     int edgeTop_2    = posY_2;
-    int edgeBottom_2 = posY_2 + sizeH_2;
-    int edgeRight_2  = posX_2 + sizeW_2;
+    int edgeBottom_2 = posY_2 + mask2->getHeight();
+    int edgeRight_2  = posX_2 + mask2->getWidth();
 
     // First check for collision of the bounding box
-    int xOverlap = std::max(0, std::min(edgeRight_1,  edgeRight_2)  - std::max(edgeLeft_1, edgeLeft_1));
-    int yOverlap = std::max(0, std::min(edgeBottom_1, edgeBottom_2) - std::max(edgeTop_1,  edgeTop_2));
-    
+    int left   = std::max(edgeLeft_1,   edgeLeft_2);
+    int right  = std::min(edgeRight_1,  edgeRight_2);
+    int top    = std::max(edgeTop_1,    edgeTop_2);
+    int bottom = std::min(edgeBottom_1, edgeBottom_2);
 
-    // Then check for collisions on a per-pixel basis, but do not iterate over all pixels.
-    if ((xOverlap != 0) && (yOverlap != 0))
+    if ((left >= right) || (top >= bottom))
     {
-        // Top-left corner of intersecting rectangle
-        int xInter = std::max(posX_1, posX_2);
-        int yInter = std::max(posY_1, posY_2);
+        return false;
+    }
 
-        // iterate only over overlapping pixels - with a certain PIXEL_STEP
-        for (int x = xInter; x < xInter + xOverlap; x += PIXEL_STEP)
-        {
-            for (int y = yInter; y < yInter + yOverlap; y += PIXEL_STEP)
-            {
-                if( isBlack(mask1, x, y) && isBlack(mask2, x, y))
-                    return true;
-            }
-        }
-        // test only bounding box
-        return true;
-    } 
-    return false;
+    // Then AND the mask rows over the overlapping rectangle, vectorized
+    // if the CPU allows (see maskKernel.cpp)
+    int offsetX_1 = left - posX_1;
+    int offsetX_2 = left - posX_2;
+
+    MaskRows rows_1;
+    rows_1.first  = mask1->getRow(frame_1, top - posY_1) + (offsetX_1 >> 6);
+    rows_1.stride = mask1->getWordsPerRow();
+    rows_1.shift  = offsetX_1 & 63;
+
+    MaskRows rows_2;
+    rows_2.first  = mask2->getRow(frame_2, top - posY_2) + (offsetX_2 >> 6);
+    rows_2.stride = mask2->getWordsPerRow();
+    rows_2.shift  = offsetX_2 & 63;
+
+    int width      = right - left;
+    int nChunks    = (width + 63) >> 6;
+    int tailBits   = width - ((nChunks - 1) << 6);
+    Uint64 tailMask = (tailBits == 64) ? ~(Uint64)0 : ((Uint64)1 << tailBits) - 1;
+
+    return getMaskKernel()(rows_1, rows_2, bottom - top, nChunks, tailMask);
 }
 
 /**
- * @brief Get pixel color of SDL surface for pixel at (x,y)
- * @return An SDL_Color struct
+ * @brief Check two moving boxes for contact during one tick
+ *
+ * Box 1 is moved relative to box 2 and clipped against it one axis at a
+ * time (slab test). Along each axis the boxes overlap during an interval
+ * of the tick; they touch if the intervals of both axes intersect. Boxes
+ * which only share an edge do not touch, like in maskCollision.
  *
- * @note If alpha is needed, SDL_GetRBGA should be used instead.
+ * @return Whether the boxes touch and the time of first contact, 0 being
+ * the start and 1 the end of the tick
  */
-SDL_Color getPixel(SDL_Surface *surface, int x, int y)
+std::pair<bool, double> sweptBoxCollision(const SDL_Rect& box1, int dx1, int dy1,
+                                          const SDL_Rect& box2, int dx2, int dy2)
 {
-    // Pixel RGB color
-    Uint8 r ;
-    Uint8 g ;
-    Uint8 b ;
-    SDL_Color color;
+    int start[2]  = { box1.x, box1.y };
+    int size1[2]  = { box1.w, box1.h };
+    int other[2]  = { box2.x, box2.y };
+    int size2[2]  = { box2.w, box2.h };
+    int motion[2] = { dx1 - dx2, dy1 - dy2 };
+
+    double enter = 0.0;
+    double leave = 1.0;
+    for (int axis = 0; axis < 2; axis++)
+    {
+        // Overlap along this axis while other - size1 < start + motion*t < other + size2
+        double low  = other[axis] - size1[axis] - start[axis];
+        double high = other[axis] + size2[axis] - start[axis];
 
-    // Get pixel coordinate (pixels are stored as a 1D array)
-    Uint32 pixel = *( ( Uint32* )surface->pixels + y * surface->w + x ) ;
+        if (0 == motion[axis])
+        {
+            if ((low >= 0) || (high <= 0))
+            {
+                return std::make_pair(false, 0.0);
+            }
+            continue;
+        }
 
-    // Get color
-    SDL_GetRGB( pixel, surface->format ,  &r, &g, &b );
-    color.r = r; // red
-    color.g = g; // green
-    color.b = b; // blue
-    color.a = 0; // alpha - we won't be using this
+        double t0 = low/motion[axis];
+        double t1 = high/motion[axis];
+        if (t0 > t1)
+        {
+            std::swap(t0, t1);
+        }
 
-    return color;
+        enter = std::max(enter, t0);
+        leave = std::min(leave, t1);
+        if (enter >= leave)
+        {
+            return std::make_pair(false, 0.0);
+        }
+    }
 
+    return std::make_pair(true, enter);
 }
 
-
 /**
- * @brief Detect if pixel is black
+ * @brief Check two masks moving over one tick for collision
  *
- * @return 1 if black, 0 otherwise
+ * Positions move in a straight line from prev to pos during the tick, with
+ * the current animation frames. Catches sprites passing through each other
+ * within one tick, which maskCollision at the end positions alone misses
+ * once the relative speed gets close to the sprite size.
  *
+ * Conservative advancement: the swept bounding boxes give the part of the
+ * tick during which the sprites can touch at all, everything before it is
+ * skipped in one step. Inside it the masks are tested each time the
+ * relative position has moved by one pixel, so no solid pixel is jumped
+ * over.
  */
-bool isBlack(SDL_Surface *surface, int x, int y)
+bool sweptMaskCollision(const BitMask* mask1, unsigned int frame_1, int prevX_1, int prevY_1, int posX_1, int posY_1,
+                        const BitMask* mask2, unsigned int frame_2, int prevX_2, int prevY_2, int posX_2, int posY_2)
 {
+    // Most hits are still hits at the end of the tick
+    if (maskCollision(mask1, frame_1, posX_1, posY_1, mask2, frame_2, posX_2, posY_2))
+    {
+        return true;
+    }
 
-    SDL_Color color = getPixel(surface, x, y);
+    if ((mask1 == NULL) || (mask2 == NULL))
+    {
+        return false;
+    }
 
-    if ( (color.r == 0)&& (color.g == 0) && (color.b == 0) )
+    // Relative motion of at most a pixel cannot jump over anything
+    int dx1 = posX_1 - prevX_1;
+    int dy1 = posY_1 - prevY_1;
+    int dx2 = posX_2 - prevX_2;
+    int dy2 = posY_2 - prevY_2;
+    int steps = std::max(std::abs(dx1 - dx2), std::abs(dy1 - dy2));
+    if (steps <= 1)
     {
-        return true;
-    } 
-    else
+        return false;
+    }
+
+    SDL_Rect box1 = { prevX_1, prevY_1, mask1->getWidth(), mask1->getHeight() };
+    SDL_Rect box2 = { prevX_2, prevY_2, mask2->getWidth(), mask2->getHeight() };
+    std::pair<bool, double> contact = sweptBoxCollision(box1, dx1, dy1, box2, dx2, dy2);
+    if (!contact.first)
     {
         return false;
     }
+
+    // Advance one pixel of relative motion at a time from the first contact
+    // of the boxes (the end of the tick was tested above). Only the offset
+    // between the masks matters, so mask 2 stays put.
+    int offsetX = prevX_1 - prevX_2;
+    int offsetY = prevY_1 - prevY_2;
+    for (int step = (int)(contact.second*steps); step < steps; step++)
+    {
+        int x = offsetX + (int)lround((double)(dx1 - dx2)*step/steps);
+        int y = offsetY + (int)lround((double)(dy1 - dy2)*step/steps);
+
+        if (maskCollision(mask1, frame_1, posX_2 + x, posY_2 + y, mask2, frame_2, posX_2, posY_2))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Get 64 pixels of a mask row, starting at pixel x
+ * Bit i of the result is pixel x + i. Relies on the padding word at the
+ * end of every BitMask row, so x may be anywhere inside the row.
+ */
+Uint64 getMaskBits(const Uint64* row, int x)
+{
+    int word  = x >> 6;
+    int shift = x & 63;
+
+    if (0 == shift)
+    {
+        return row[word];
+    }
+
+    return (row[word] >> shift) | (row[word + 1] << (64 - shift));
 }
@@ -0,0 +1,234 @@
+/**
+ * @file
+ *
+ * @brief Defines the compiled sprite manifest
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spriteManifest.h"
+
+/**
+ * @class Sprite definitions (sheet, frame rectangles and durations, mask
+ * and layer) compiled offline from a text manifest by engineZManifest.
+ * The compiled file is mapped into memory and read in place, so startup
+ * neither parses text nor copies anything.
+ */
+SpriteManifest::SpriteManifest(const std::string& filename)
+    :mFile(filename)
+{
+    validate();
+}
+
+// Destructor
+SpriteManifest::~SpriteManifest()
+{
+
+}
+
+/**
+ * @brief Get number of sprites
+ */
+unsigned int SpriteManifest::size() const
+{
+    return SDL_SwapLE32(mHeader->nSprites);
+}
+
+/**
+ * @brief Get index of a sprite by name
+ * Linear, manifests hold a handful of sprites and are searched at startup.
+ */
+int SpriteManifest::find(const std::string& name) const
+{
+    for (unsigned int i = 0; i < size(); i++)
+    {
+        if (name == getString(mSprites[i].name))
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Get name of sprite
+ */
+std::string SpriteManifest::getName(unsigned int i) const
+{
+    return getString(getSprite(i).name);
+}
+
+/**
+ * @brief Get path of the sprite sheet of sprite
+ */
+std::string SpriteManifest::getSheet(unsigned int i) const
+{
+    return mFile.getDirectory() + "/" + getString(getSprite(i).sheet);
+}
+
+/**
+ * @brief Get path of the image the collision mask of sprite is made from
+ * Usually the sprite sheet itself.
+ */
+std::string SpriteManifest::getMask(unsigned int i) const
+{
+    return mFile.getDirectory() + "/" + getString(getSprite(i).mask);
+}
+
+/**
+ * @brief Get layer sprite is drawn on
+ */
+int SpriteManifest::getLayer(unsigned int i) const
+{
+    return (Sint32)SDL_SwapLE32(getSprite(i).layer);
+}
+
+/**
+ * @brief Get number of animation frames of sprite
+ */
+unsigned int SpriteManifest::getNFrames(unsigned int i) const
+{
+    return SDL_SwapLE32(getSprite(i).nFrames);
+}
+
+/**
+ * @brief Get rectangle of animation frame k of sprite in its sheet
+ */
+SDL_Rect SpriteManifest::getFrame(unsigned int i, unsigned int k) const
+{
+    if (k >= getNFrames(i))
+    {
+        throw std::out_of_range(" Unknown animation frame!");
+    }
+
+    const ManifestFrame& frame = mFrames[SDL_SwapLE32(getSprite(i).firstFrame) + k];
+
+    SDL_Rect rect;
+    rect.x = (Sint32)SDL_SwapLE32(frame.x);
+    rect.y = (Sint32)SDL_SwapLE32(frame.y);
+    rect.w = (Sint32)SDL_SwapLE32(frame.w);
+    rect.h = (Sint32)SDL_SwapLE32(frame.h);
+
+    return rect;
+}
+
+/**
+ * @brief Get number of ticks animation frame k of sprite is shown
+ */
+unsigned int SpriteManifest::getDuration(unsigned int i, unsigned int k) const
+{
+    if (k >= getNFrames(i))
+    {
+        throw std::out_of_range(" Unknown animation frame!");
+    }
+
+    return SDL_SwapLE32(mFrames[SDL_SwapLE32(getSprite(i).firstFrame) + k].duration);
+}
+
+/**
+ * @brief Get ticks of every animation frame of sprite
+ */
+std::vector<unsigned int> SpriteManifest::getDurations(unsigned int i) const
+{
+    std::vector<unsigned int> durations(getNFrames(i));
+    for (unsigned int k = 0; k < durations.size(); k++)
+    {
+        durations[k] = getDuration(i, k);
+    }
+
+    return durations;
+}
+
+/**
+ * @brief Check layout of the file
+ * Everything referred to must lie inside the file, so that accessors do
+ * not need to check again.
+ */
+void SpriteManifest::validate()
+{
+    const unsigned char* data = mFile.getData();
+    std::size_t size          = mFile.getSize();
+
+    if (size < sizeof(ManifestHeader))
+    {
+        throw std::runtime_error(" Sprite manifest is truncated!");
+    }
+
+    mHeader = reinterpret_cast<const ManifestHeader*>(data);
+    if ((SDL_SwapLE32(mHeader->magic) != MANIFEST_MAGIC) ||
+        (SDL_SwapLE32(mHeader->version) != MANIFEST_VERSION))
+    {
+        throw std::runtime_error(" Not a compiled sprite manifest, or an old one!");
+    }
+
+    std::size_t nSprites      = SDL_SwapLE32(mHeader->nSprites);
+    std::size_t nFrames       = SDL_SwapLE32(mHeader->nFrames);
+    std::size_t stringsOffset = SDL_SwapLE32(mHeader->stringsOffset);
+    std::size_t stringsSize   = SDL_SwapLE32(mHeader->stringsSize);
+    std::size_t framesOffset  = sizeof(ManifestHeader) + nSprites*sizeof(ManifestSprite);
+
+    if ((framesOffset + nFrames*sizeof(ManifestFrame) > stringsOffset) ||
+        (stringsOffset + stringsSize > size) ||
+        (0 == stringsSize) || (data[stringsOffset + stringsSize - 1] != 0))
+    {
+        throw std::runtime_error(" Sprite manifest is corrupt!");
+    }
+
+    mSprites = reinterpret_cast<const ManifestSprite*>(data + sizeof(ManifestHeader));
+    mFrames  = reinterpret_cast<const ManifestFrame*>(data + framesOffset);
+    mStrings = reinterpret_cast<const char*>(data + stringsOffset);
+
+    for (std::size_t i = 0; i < nSprites; i++)
+    {
+        const ManifestSprite& sprite = mSprites[i];
+        if ((SDL_SwapLE32(sprite.name)  >= stringsSize) ||
+            (SDL_SwapLE32(sprite.sheet) >= stringsSize) ||
+            (SDL_SwapLE32(sprite.mask)  >= stringsSize) ||
+            (0 == SDL_SwapLE32(sprite.nFrames)) ||
+            (SDL_SwapLE32(sprite.firstFrame) + (std::size_t)SDL_SwapLE32(sprite.nFrames) > nFrames))
+        {
+            throw std::runtime_error(" Sprite manifest is corrupt!");
+        }
+    }
+}
+
+/**
+ * @brief Get string at an offset of the string table
+ */
+const char* SpriteManifest::getString(Uint32 offset) const
+{
+    return mStrings + SDL_SwapLE32(offset);
+}
+
+/**
+ * @brief Get sprite record
+ */
+const ManifestSprite& SpriteManifest::getSprite(unsigned int i) const
+{
+    if (i >= size())
+    {
+        throw std::out_of_range(" Unknown sprite!");
+    }
+
+    return mSprites[i];
+}
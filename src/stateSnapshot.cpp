@@ -0,0 +1,153 @@
+/**
+ * @file
+ *
+ * @brief Defines a copy of everything needed to draw one simulation tick
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stateSnapshot.h"
+
+/**
+ * @class Snapshot of the drawable game state after a simulation tick. The
+ * simulation thread fills one while the render thread draws another, so
+ * neither has to touch the other's data (see Pipeline).
+ */
+StateSnapshot::StateSnapshot()
+{
+    mTime      = 0;
+    mInputTime = 0;
+    mTick      = 0;
+}
+
+// Destructor
+StateSnapshot::~StateSnapshot()
+{
+
+}
+
+/**
+ * @brief Remove all sprites
+ * Memory is kept, so refilling a snapshot every tick does not allocate.
+ */
+void StateSnapshot::clear()
+{
+    mTexture.clear();
+    mClip.clear();
+    mPrevX.clear();
+    mPrevY.clear();
+    mX.clear();
+    mY.clear();
+    mLayer.clear();
+}
+
+/**
+ * @brief Add a sprite
+ */
+void StateSnapshot::add(SDL_Texture* texture, const SDL_Rect& clip, int prevX, int prevY,
+                        int x, int y, int layer)
+{
+    mTexture.push_back(texture);
+    mClip.push_back(clip);
+    mPrevX.push_back(prevX);
+    mPrevY.push_back(prevY);
+    mX.push_back(x);
+    mY.push_back(y);
+    mLayer.push_back(layer);
+}
+
+/**
+ * @brief Queue every sprite in a sprite batch
+ * alpha = 0 draws sprites at the previous tick's position and
+ * alpha = 1 at the current one.
+ */
+void StateSnapshot::draw(SpriteBatch& batch, double alpha) const
+{
+    unsigned int n = mTexture.size();
+    for (unsigned int i = 0; i < n; i++)
+    {
+        SDL_Rect renderQuad;
+        renderQuad.x = mPrevX[i] + (int)((mX[i] - mPrevX[i])*alpha);
+        renderQuad.y = mPrevY[i] + (int)((mY[i] - mPrevY[i])*alpha);
+        renderQuad.w = mClip[i].w;
+        renderQuad.h = mClip[i].h;
+
+        batch.draw(mTexture[i], mClip[i], renderQuad, mLayer[i]);
+    }
+}
+
+/**
+ * @brief Get number of sprites
+ */
+unsigned int StateSnapshot::size() const
+{
+    return mTexture.size();
+}
+
+/**
+ * @brief Get time of the tick the snapshot was taken at
+ */
+Uint64 StateSnapshot::getTime() const
+{
+    return mTime;
+}
+
+/**
+ * @brief Set time of the tick the snapshot was taken at
+ */
+void StateSnapshot::setTime(Uint64 time)
+{
+    mTime = time;
+}
+
+/**
+ * @brief Get number of ticks run when the snapshot was taken
+ */
+unsigned long StateSnapshot::getTick() const
+{
+    return mTick;
+}
+
+/**
+ * @brief Set number of ticks run when the snapshot was taken
+ */
+void StateSnapshot::setTick(unsigned long tick)
+{
+    mTick = tick;
+}
+
+/**
+ * @brief Get time of the oldest input applied in the tick
+ * For measuring input latency, see Input::presented().
+ */
+Uint64 StateSnapshot::getInputTime() const
+{
+    return mInputTime;
+}
+
+/**
+ * @brief Set time of the oldest input applied in the tick
+ */
+void StateSnapshot::setInputTime(Uint64 inputTime)
+{
+    mInputTime = inputTime;
+}
@@ -0,0 +1,231 @@
+/**
+ * @file
+ *
+ * @brief Defines a packer which puts many sprite sheets into a few textures
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "textureAtlas.h"
+#include "assetCache.h"
+
+/**
+ * @brief Premultiply color by alpha in a rectangle of an ARGB8888 surface
+ */
+static void premultiply(SDL_Surface* surface, const SDL_Rect& rect)
+{
+    for (int y = rect.y; y < rect.y + rect.h; y++)
+    {
+        Uint32* row = (Uint32*)((Uint8*)surface->pixels + y*surface->pitch);
+        for (int x = rect.x; x < rect.x + rect.w; x++)
+        {
+            Uint32 a = row[x] >> 24;
+            Uint32 r = ((row[x] >> 16) & 0xFF)*a/255;
+            Uint32 g = ((row[x] >> 8) & 0xFF)*a/255;
+            Uint32 b = (row[x] & 0xFF)*a/255;
+            row[x] = (a << 24) | (r << 16) | (g << 8) | b;
+        }
+    }
+}
+
+/**
+ * @class Texture atlas. Sprite sheets are packed into a few large textures
+ * at startup (shelf packing, tallest first), so that a SpriteBatch can draw
+ * sprites from different sheets without switching textures. Sprites keep
+ * using their own sheet texture; lookup translates it into the atlas page
+ * and clip.
+ */
+TextureAtlas::TextureAtlas()
+{
+
+}
+
+// Destructor
+TextureAtlas::~TextureAtlas()
+{
+
+}
+
+/**
+ * @brief Add a sprite sheet
+ * Adding the same file twice has no effect.
+ */
+void TextureAtlas::add(const std::string& filename)
+{
+    if (std::find(mFilenames.begin(), mFilenames.end(), filename) == mFilenames.end())
+    {
+        mFilenames.push_back(filename);
+    }
+}
+
+/**
+ * @brief Pack every added sprite sheet into atlas pages
+ * Sheets which do not fit into a page on their own are left out and keep
+ * being drawn from their own texture. Any previous pages are dropped.
+ * @return false if a page could not be created
+ */
+bool TextureAtlas::build()
+{
+    mPages.clear();
+    mPage.clear();
+    mOffset.clear();
+    mSheets.clear();
+
+    // Gather images, tallest first, which packs shelves tighter
+    std::vector< std::pair<int, unsigned int> > order;
+    std::vector< std::shared_ptr<SDL_Surface> > surfaces;
+    for (unsigned int i = 0; i < mFilenames.size(); i++)
+    {
+        std::shared_ptr<SDL_Surface> surface = assetCache.getSurface(mFilenames[i]);
+        std::shared_ptr<SDL_Texture> sheet   = assetCache.getTexture(mFilenames[i]);
+        surfaces.push_back(surface);
+        mSheets.push_back(sheet);
+
+        if ((surface != NULL) && (sheet != NULL) &&
+            (surface->w + 2*ATLAS_PADDING <= ATLAS_SIZE) &&
+            (surface->h + 2*ATLAS_PADDING <= ATLAS_SIZE))
+        {
+            order.push_back(std::make_pair(-surface->h, i));
+        }
+    }
+    std::sort(order.begin(), order.end());
+
+    // Shelf packing: images are put left to right on a shelf, a new shelf
+    // is opened below when the current one is full and a new page when
+    // the page is full
+    std::vector<unsigned int> page(mFilenames.size());
+    std::vector<SDL_Point> offset(mFilenames.size());
+    std::vector<int> pageHeight;
+    int shelfX = 0, shelfY = 0, shelfH = 0;
+    if (!order.empty())
+    {
+        pageHeight.push_back(0);
+    }
+    for (unsigned int k = 0; k < order.size(); k++)
+    {
+        SDL_Surface* surface = surfaces[order[k].second].get();
+        int w = surface->w + 2*ATLAS_PADDING;
+        int h = surface->h + 2*ATLAS_PADDING;
+
+        if (shelfX + w > ATLAS_SIZE)
+        {
+            shelfX  = 0;
+            shelfY += shelfH;
+            shelfH  = 0;
+        }
+        if (shelfY + h > ATLAS_SIZE)
+        {
+            shelfX = 0;
+            shelfY = 0;
+            shelfH = 0;
+            pageHeight.push_back(0);
+        }
+
+        page[order[k].second]     = pageHeight.size() - 1;
+        offset[order[k].second].x = shelfX + ATLAS_PADDING;
+        offset[order[k].second].y = shelfY + ATLAS_PADDING;
+
+        shelfX += w;
+        shelfH  = std::max(shelfH, h);
+        pageHeight.back() = std::max(pageHeight.back(), shelfY + shelfH);
+    }
+
+    // Render pages. Pages are only as tall as needed.
+    for (unsigned int p = 0; p < pageHeight.size(); p++)
+    {
+        // ARGB8888, cleared to fully transparent
+        SDL_Surface* pageSurface = SDL_CreateRGBSurface(0, ATLAS_SIZE, pageHeight[p], 32,
+                                                        0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+        if (pageSurface == NULL)
+        {
+            printf( "Unable to create atlas page! SDL Error: %s\n", SDL_GetError() );
+            return false;
+        }
+
+        for (unsigned int k = 0; k < order.size(); k++)
+        {
+            unsigned int i = order[k].second;
+            if (page[i] != p)
+            {
+                continue;
+            }
+
+            // Copy as is; color keyed pixels are skipped and stay transparent
+            SDL_Rect dst = { offset[i].x, offset[i].y, surfaces[i]->w, surfaces[i]->h };
+            SDL_SetSurfaceBlendMode(surfaces[i].get(), SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(surfaces[i].get(), NULL, pageSurface, &dst);
+
+            // Pages hold premultiplied alpha, like baked images
+            if (!assetCache.isPremultiplied(mFilenames[i]))
+            {
+                premultiply(pageSurface, dst);
+            }
+        }
+
+        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, pageSurface);
+        SDL_FreeSurface(pageSurface);
+        if (texture == NULL)
+        {
+            printf( "Unable to create atlas texture! SDL Error: %s\n", SDL_GetError() );
+            return false;
+        }
+        setPremultipliedBlendMode(texture);
+        mPages.push_back(std::shared_ptr<SDL_Texture>(texture, SDL_DestroyTexture));
+    }
+
+    for (unsigned int k = 0; k < order.size(); k++)
+    {
+        unsigned int i = order[k].second;
+        mPage[mSheets[i].get()]   = page[i];
+        mOffset[mSheets[i].get()] = offset[i];
+    }
+
+    return true;
+}
+
+/**
+ * @brief Translate a sprite sheet texture and clip into the atlas
+ * clip is moved to the position of the sheet in the atlas page.
+ * @return The atlas page, or the sheet itself if it is not in the atlas
+ */
+SDL_Texture* TextureAtlas::lookup(SDL_Texture* sheet, SDL_Rect& clip) const
+{
+    std::map<SDL_Texture*, unsigned int>::const_iterator it = mPage.find(sheet);
+    if (it == mPage.end())
+    {
+        return sheet;
+    }
+
+    const SDL_Point& offset = mOffset.find(sheet)->second;
+    clip.x += offset.x;
+    clip.y += offset.y;
+
+    return mPages[it->second].get();
+}
+
+/**
+ * @brief Get number of atlas pages
+ */
+unsigned int TextureAtlas::getNPages() const
+{
+    return mPages.size();
+}
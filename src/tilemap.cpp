@@ -0,0 +1,587 @@
+/**
+ * @file
+ *
+ * @brief Defines tile maps, drawn from cached chunks
+ *
+ * @author Alexandre Lopes
+ *
+ * @copyright (c) 2015 Alexandre Lopes. This project is released under the GNU Public License.
+ *
+ */
+
+/* This file is part of EngineZ.
+ *
+ * EngineZ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EngineZ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EngineZ. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tilemap.h"
+
+/**
+ * @brief Round a division towards minus infinity
+ */
+static int floorDiv(int a, int b)
+{
+    return (a >= 0) ? a/b : -((-a + b - 1)/b);
+}
+
+/**
+ * @brief Get tile index of a character of a map row
+ * @return -1 for '.' (no tile) and unknown characters
+ */
+static int decodeTile(char c)
+{
+    if ((c >= '0') && (c <= '9'))
+    {
+        return c - '0';
+    }
+    if ((c >= 'A') && (c <= 'Z'))
+    {
+        return 10 + c - 'A';
+    }
+    if ((c >= 'a') && (c <= 'z'))
+    {
+        return 36 + c - 'a';
+    }
+
+    return -1;
+}
+
+/**
+ * @class Tile map, e.g. a level's scrolling background. Drawing every tile
+ * every frame would cost one sprite per tile, so the map is cut into
+ * chunks of TILEMAP_CHUNK_TILES x TILEMAP_CHUNK_TILES tiles, and each
+ * chunk is rendered once into a render target texture. A frame then
+ * queues one sprite per visible chunk, i.e. the cost follows the screen
+ * size rather than the number of tiles.
+ *
+ * Chunks are streamed as the view moves: visible chunks are built when
+ * needed, up to TILEMAP_PREFETCH chunks per frame are built ahead of
+ * time in a ring of one chunk around the view, and chunks leaving that
+ * ring are released. Their textures are pooled, so scrolling does not
+ * create and destroy textures all the time. Changing a tile rebuilds its
+ * chunk the next time it is drawn.
+ *
+ * The map is drawn through a SpriteBatch on its own layer, so it gets
+ * the layer's camera transform (e.g. parallax) and viewport culling.
+ * Renderers without render targets draw the visible tiles one by one.
+ */
+Tilemap::Tilemap()
+    :mTileWidth(0),
+     mTileHeight(0),
+     mColumns(0),
+     mWidth(0),
+     mHeight(0),
+     mRepeat(false),
+     mLayer(0),
+     mTargets(false),
+     mChunksX(0),
+     mChunksY(0),
+     mFrame(0),
+     mNBuilt(0),
+     mNDrawn(0),
+     mPrefetched(0)
+{
+
+}
+
+// Destructor
+Tilemap::~Tilemap()
+{
+
+}
+
+/**
+ * @brief Load a map from a text file
+ * One statement per line, # starts a comment:
+ * @code
+ * tileset <image> <tile width> <tile height>
+ * size <width> <height>
+ * row <tiles>
+ * @endcode
+ * The tileset path is relative to the map file. Each row statement gives
+ * the next row of tiles, one character per tile: 0-9, A-Z and a-z are
+ * tiles 0 to 61 of the tileset (left to right, then top to bottom), '.'
+ * is no tile.
+ * @return false if the file could not be read or is invalid
+ */
+bool Tilemap::load(const std::string& filename)
+{
+    std::ifstream input(filename.c_str());
+    if (!input)
+    {
+        printf( "Unable to load tile map %s!\n", filename.c_str() );
+        return false;
+    }
+
+    std::string::size_type slash = filename.find_last_of('/');
+    std::string directory = (slash == std::string::npos) ? "." : filename.substr(0, slash);
+
+    std::string tileset;
+    int tileWidth = 0, tileHeight = 0;
+    int row = 0;
+
+    std::string line;
+    unsigned int lineNumber = 0;
+    while (std::getline(input, line))
+    {
+        lineNumber++;
+
+        std::size_t comment = line.find('#');
+        if (comment != std::string::npos)
+        {
+            line.erase(comment);
+        }
+
+        std::istringstream tokens(line);
+        std::string keyword;
+        if (!(tokens >> keyword))
+        {
+            continue;
+        }
+
+        bool ok = true;
+        if (keyword == "tileset")
+        {
+            ok = static_cast<bool>(tokens >> tileset >> tileWidth >> tileHeight);
+        }
+        else if ((keyword == "size") && !tileset.empty())
+        {
+            int width, height;
+            ok = (tokens >> width >> height) &&
+                 create(directory + "/" + tileset, tileWidth, tileHeight, width, height);
+            row = 0;
+        }
+        else if ((keyword == "row") && (row < mHeight))
+        {
+            std::string tiles;
+            ok = (tokens >> tiles) && ((int)tiles.size() == mWidth);
+            for (int x = 0; ok && (x < mWidth); x++)
+            {
+                setTile(x, row, decodeTile(tiles[x]));
+            }
+            row++;
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if (!ok)
+        {
+            printf( "%s:%u: invalid tile map statement!\n", filename.c_str(), lineNumber );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Make an empty map
+ * @param tileset Image holding the tiles, in rows of tileWidth x tileHeight
+ * @return false if the tileset could not be loaded
+ */
+bool Tilemap::create(const std::string& tileset, int tileWidth, int tileHeight, int width, int height)
+{
+    mTileset = assetCache.getTexture(tileset);
+
+    int tilesetWidth = 0, tilesetHeight = 0;
+    if( (mTileset == NULL) ||
+        (SDL_QueryTexture( mTileset.get(), NULL, NULL, &tilesetWidth, &tilesetHeight ) != 0) ||
+        (tileWidth <= 0) || (tileHeight <= 0) || (tilesetWidth < tileWidth) || (tilesetHeight < tileHeight) ||
+        (width <= 0) || (height <= 0) )
+    {
+        printf( "Unable to make a tile map from %s!\n", tileset.c_str() );
+        mTileset.reset();
+        return false;
+    }
+
+    mTileWidth  = tileWidth;
+    mTileHeight = tileHeight;
+    mColumns    = tilesetWidth/tileWidth;
+    mWidth      = width;
+    mHeight     = height;
+    mTiles.assign(width*height, -1);
+    mTargets    = (SDL_RenderTargetSupported( renderer ) == SDL_TRUE);
+
+    Chunk empty = { std::shared_ptr<SDL_Texture>(), false, 0 };
+    mChunksX = (width + TILEMAP_CHUNK_TILES - 1)/TILEMAP_CHUNK_TILES;
+    mChunksY = (height + TILEMAP_CHUNK_TILES - 1)/TILEMAP_CHUNK_TILES;
+    mChunks.assign(mChunksX*mChunksY, empty);
+    mResident.clear();
+    mPool.clear();
+
+    return true;
+}
+
+/**
+ * @brief Get tile at a map position
+ * @return Tile index, -1 if there is none
+ */
+int Tilemap::getTile(int x, int y) const
+{
+    if ((x < 0) || (x >= mWidth) || (y < 0) || (y >= mHeight))
+    {
+        throw std::out_of_range(" Invalid tile position!");
+    }
+
+    return mTiles[y*mWidth + x];
+}
+
+/**
+ * @brief Set tile at a map position
+ * @param tile Tile index, -1 for none
+ */
+void Tilemap::setTile(int x, int y, int tile)
+{
+    if ((x < 0) || (x >= mWidth) || (y < 0) || (y >= mHeight))
+    {
+        throw std::out_of_range(" Invalid tile position!");
+    }
+
+    mTiles[y*mWidth + x] = tile;
+    mChunks[(y/TILEMAP_CHUNK_TILES)*mChunksX + x/TILEMAP_CHUNK_TILES].dirty = true;
+}
+
+/**
+ * @brief Repeat the map endlessly in both directions
+ * Off by default, i.e. there is nothing outside the map.
+ */
+void Tilemap::setRepeat(bool repeat)
+{
+    mRepeat = repeat;
+}
+
+/**
+ * @brief Set sprite batch layer the map is drawn on
+ */
+void Tilemap::setLayer(int layer)
+{
+    mLayer = layer;
+}
+
+/**
+ * @brief Get sprite batch layer the map is drawn on
+ */
+int Tilemap::getLayer() const
+{
+    return mLayer;
+}
+
+/**
+ * @brief Queue the visible part of the map
+ * Call once per frame, before the batch is flushed. Builds missing
+ * visible chunks, a few around them, and releases chunks out of view.
+ * The map's top left corner is at world position (0, 0).
+ */
+void Tilemap::draw(SpriteBatch& batch)
+{
+    if (mTileset == NULL)
+    {
+        return;
+    }
+
+    mFrame++;
+    mNDrawn     = 0;
+    mPrefetched = 0;
+
+    SDL_Rect view = batch.getView(mLayer);
+    visit(batch, view, true);
+
+    int chunkWidth  = TILEMAP_CHUNK_TILES*mTileWidth;
+    int chunkHeight = TILEMAP_CHUNK_TILES*mTileHeight;
+    SDL_Rect around = { view.x - chunkWidth, view.y - chunkHeight,
+                        view.w + 2*chunkWidth, view.h + 2*chunkHeight };
+    visit(batch, around, false);
+
+    evict();
+}
+
+/**
+ * @brief Forget the content of every chunk
+ * Call when SDL reports that render targets were reset; chunks are then
+ * rebuilt as they are drawn.
+ */
+void Tilemap::invalidate()
+{
+    for (unsigned int i = 0; i < mResident.size(); i++)
+    {
+        mChunks[mResident[i]].dirty = true;
+    }
+}
+
+/**
+ * @brief Get width in tiles
+ */
+int Tilemap::getWidth() const
+{
+    return mWidth;
+}
+
+/**
+ * @brief Get height in tiles
+ */
+int Tilemap::getHeight() const
+{
+    return mHeight;
+}
+
+/**
+ * @brief Get number of chunks with a texture
+ */
+unsigned int Tilemap::getNResident() const
+{
+    return mResident.size();
+}
+
+/**
+ * @brief Get number of chunks built so far
+ */
+unsigned long Tilemap::getNBuilt() const
+{
+    return mNBuilt;
+}
+
+/**
+ * @brief Get number of chunks queued by the last draw
+ */
+unsigned int Tilemap::getNDrawn() const
+{
+    return mNDrawn;
+}
+
+/**
+ * @brief Visit chunks covering a world rectangle
+ * Every chunk visited is kept for this frame.
+ * @param visible The area is visible: chunks are built and queued.
+ * Otherwise they are only prefetched, within TILEMAP_PREFETCH.
+ */
+void Tilemap::visit(SpriteBatch& batch, const SDL_Rect& area, bool visible)
+{
+    int mapWidth    = mWidth*mTileWidth;
+    int mapHeight   = mHeight*mTileHeight;
+    int chunkWidth  = TILEMAP_CHUNK_TILES*mTileWidth;
+    int chunkHeight = TILEMAP_CHUNK_TILES*mTileHeight;
+
+    // Copies of the map overlapping the area, only the map itself unless repeating
+    int firstCopyX = 0, lastCopyX = 0, firstCopyY = 0, lastCopyY = 0;
+    if (mRepeat)
+    {
+        firstCopyX = floorDiv(area.x, mapWidth);
+        lastCopyX  = floorDiv(area.x + area.w - 1, mapWidth);
+        firstCopyY = floorDiv(area.y, mapHeight);
+        lastCopyY  = floorDiv(area.y + area.h - 1, mapHeight);
+    }
+
+    for (int copyY = firstCopyY; copyY <= lastCopyY; copyY++)
+    {
+        for (int copyX = firstCopyX; copyX <= lastCopyX; copyX++)
+        {
+            // Part of the area on this copy, in map coordinates
+            int originX = copyX*mapWidth;
+            int originY = copyY*mapHeight;
+            int left    = std::max(area.x - originX, 0);
+            int right   = std::min(area.x + area.w - originX, mapWidth);
+            int top     = std::max(area.y - originY, 0);
+            int bottom  = std::min(area.y + area.h - originY, mapHeight);
+            if ((left >= right) || (top >= bottom))
+            {
+                continue;
+            }
+
+            for (int cy = top/chunkHeight; cy <= (bottom - 1)/chunkHeight; cy++)
+            {
+                for (int cx = left/chunkWidth; cx <= (right - 1)/chunkWidth; cx++)
+                {
+                    unsigned int c = cy*mChunksX + cx;
+                    Chunk& chunk = mChunks[c];
+                    chunk.used = mFrame;
+
+                    int x = originX + cx*chunkWidth;
+                    int y = originY + cy*chunkHeight;
+                    if (!visible)
+                    {
+                        if (mTargets && ((chunk.texture == NULL) || chunk.dirty) &&
+                            (mPrefetched < TILEMAP_PREFETCH))
+                        {
+                            build(c);
+                            mPrefetched++;
+                        }
+                    }
+                    else if (mTargets && build(c))
+                    {
+                        std::pair<int, int> size = getChunkSize(c);
+                        SDL_Rect clip = { 0, 0, size.first, size.second };
+                        SDL_Rect dst  = { x, y, size.first, size.second };
+                        batch.draw(chunk.texture.get(), clip, dst, mLayer);
+                        mNDrawn++;
+                    }
+                    else
+                    {
+                        drawTiles(batch, c, x, y);
+                        mNDrawn++;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Make sure a chunk's texture is up to date
+ * Renders its tiles into a render target, taken from the pool if there
+ * is one. If render targets fail, the map falls back to drawing tiles.
+ * @return false if the chunk has no up to date texture
+ */
+bool Tilemap::build(unsigned int chunk)
+{
+    Chunk& target = mChunks[chunk];
+    if ((target.texture != NULL) && !target.dirty)
+    {
+        return true;
+    }
+
+    if (target.texture == NULL)
+    {
+        if (!mPool.empty())
+        {
+            target.texture = mPool.back();
+            mPool.pop_back();
+        }
+        else
+        {
+            SDL_Texture* texture = SDL_CreateTexture( renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET,
+                                                      TILEMAP_CHUNK_TILES*mTileWidth,
+                                                      TILEMAP_CHUNK_TILES*mTileHeight );
+            if( texture == NULL )
+            {
+                printf( "Unable to create tile map chunk, drawing tiles instead! SDL Error: %s\n", SDL_GetError() );
+                mTargets = false;
+                return false;
+            }
+            setPremultipliedBlendMode( texture );
+            target.texture = std::shared_ptr<SDL_Texture>(texture, SDL_DestroyTexture);
+        }
+        mResident.push_back(chunk);
+    }
+
+    SDL_Texture* previous = SDL_GetRenderTarget( renderer );
+    if( SDL_SetRenderTarget( renderer, target.texture.get() ) != 0 )
+    {
+        printf( "Unable to render tile map chunk, drawing tiles instead! SDL Error: %s\n", SDL_GetError() );
+        mTargets = false;
+        return false;
+    }
+
+    // Cleared to transparent; tiles blended onto it leave premultiplied
+    // alpha, whether the tileset holds premultiplied alpha or not
+    SDL_SetRenderDrawColor( renderer, 0, 0, 0, 0 );
+    SDL_RenderClear( renderer );
+
+    int firstX = (chunk % mChunksX)*TILEMAP_CHUNK_TILES;
+    int firstY = (chunk/mChunksX)*TILEMAP_CHUNK_TILES;
+    int lastX  = std::min(firstX + TILEMAP_CHUNK_TILES, mWidth);
+    int lastY  = std::min(firstY + TILEMAP_CHUNK_TILES, mHeight);
+    for (int y = firstY; y < lastY; y++)
+    {
+        for (int x = firstX; x < lastX; x++)
+        {
+            int tile = mTiles[y*mWidth + x];
+            if (tile < 0)
+            {
+                continue;
+            }
+
+            SDL_Rect src = { (tile % mColumns)*mTileWidth, (tile/mColumns)*mTileHeight, mTileWidth, mTileHeight };
+            SDL_Rect dst = { (x - firstX)*mTileWidth, (y - firstY)*mTileHeight, mTileWidth, mTileHeight };
+            SDL_RenderCopy( renderer, mTileset.get(), &src, &dst );
+        }
+    }
+
+    SDL_SetRenderTarget( renderer, previous );
+
+    target.dirty = false;
+    mNBuilt++;
+
+    return true;
+}
+
+/**
+ * @brief Queue the tiles of a chunk one by one
+ * The batch culls tiles out of view.
+ * @param x World position of the chunk
+ * @param y World position of the chunk
+ */
+void Tilemap::drawTiles(SpriteBatch& batch, unsigned int chunk, int x, int y)
+{
+    int firstX = (chunk % mChunksX)*TILEMAP_CHUNK_TILES;
+    int firstY = (chunk/mChunksX)*TILEMAP_CHUNK_TILES;
+    int lastX  = std::min(firstX + TILEMAP_CHUNK_TILES, mWidth);
+    int lastY  = std::min(firstY + TILEMAP_CHUNK_TILES, mHeight);
+    for (int ty = firstY; ty < lastY; ty++)
+    {
+        for (int tx = firstX; tx < lastX; tx++)
+        {
+            int tile = mTiles[ty*mWidth + tx];
+            if (tile < 0)
+            {
+                continue;
+            }
+
+            SDL_Rect src = { (tile % mColumns)*mTileWidth, (tile/mColumns)*mTileHeight, mTileWidth, mTileHeight };
+            SDL_Rect dst = { x + (tx - firstX)*mTileWidth, y + (ty - firstY)*mTileHeight, mTileWidth, mTileHeight };
+            batch.draw(mTileset.get(), src, dst, mLayer);
+        }
+    }
+}
+
+/**
+ * @brief Get size of a chunk in pixels
+ * Chunks at the right and bottom edges hold fewer tiles.
+ */
+std::pair<int, int> Tilemap::getChunkSize(unsigned int chunk) const
+{
+    int tilesX = std::min(TILEMAP_CHUNK_TILES, mWidth - (int)(chunk % mChunksX)*TILEMAP_CHUNK_TILES);
+    int tilesY = std::min(TILEMAP_CHUNK_TILES, mHeight - (int)(chunk/mChunksX)*TILEMAP_CHUNK_TILES);
+
+    return std::make_pair(tilesX*mTileWidth, tilesY*mTileHeight);
+}
+
+/**
+ * @brief Release textures of chunks not used in the current frame
+ * Up to TILEMAP_POOL textures are kept for chunks coming into view.
+ */
+void Tilemap::evict()
+{
+    unsigned int i = 0;
+    while (i < mResident.size())
+    {
+        Chunk& chunk = mChunks[mResident[i]];
+        if (chunk.used == mFrame)
+        {
+            i++;
+            continue;
+        }
+
+        if (mPool.size() < TILEMAP_POOL)
+        {
+            mPool.push_back(chunk.texture);
+        }
+        chunk.texture.reset();
+        chunk.dirty = false;
+
+        mResident[i] = mResident.back();
+        mResident.pop_back();
+    }
+}
@@ -29,19 +29,31 @@
 
 
 // Constructor
-User::User(int width, int height, int nSprites, std::string filename)
+User::User(int width, int height, int nSprites, const std::string& filename)
      :Sprite(width, height, nSprites, filename)
 {
     //Default values
     mHP  = 100;
 }
 
+//Copy constructor
+User::User(const User& other) = default;
+
+//Move constructor
+User::User(User&& other) noexcept = default;
+
 //Destructor
 User::~User()
 {
 
 }
 
+//Copy assignment
+User& User::operator=(const User& other) = default;
+
+//Move assignment
+User& User::operator=(User&& other) noexcept = default;
+
 /**
  * @brief Get HP
  */